@@ -0,0 +1,61 @@
+#ifndef BUTTONLADDER_H
+#define BUTTONLADDER_H
+//
+// Resistive steering wheel button ladder on the ADC.
+//
+// Each sample() takes exactly LADDER_OVERSAMPLE reads and averages them, then looks the level up in the vehicle's
+// threshold table, so the cost per call is fixed whatever the buttons are doing.  A button has to classify the same
+// for LADDER_DEBOUNCE_SAMPLES samples in a row before it counts as pressed or released.
+//
+// sample() reports INPUT_LADDER events with the button's table index, what they queue is up to the router.  The
+// table's command / holdCommand are the vehicle's default layout, BindInputs() binds them to INPUT_PRESS and
+// INPUT_LONG_PRESS, here they only pick the timing.  A button with no holdCommand reports INPUT_PRESS once on press,
+// and with LADDER_REPEAT also auto-repeats it after LADDER_HOLD_MS (volume only, a held mute or track button must not
+// toggle / skip over and over).  One with a holdCommand reports INPUT_PRESS on a short press (at release) and
+// INPUT_LONG_PRESS once when held.
+//
+#include <Arduino.h>
+#include "InputRouter.h"
+
+#ifndef LADDER_OVERSAMPLE
+#define LADDER_OVERSAMPLE         4         // analogRead()s per sample, each is roughly 100us on the ESP8266
+#endif
+#define LADDER_DEBOUNCE_SAMPLES   3
+#define LADDER_HOLD_MS            600
+#define LADDER_REPEAT_MS          200
+
+#define LADDER_ONCE               0         // LadderButton flags
+#define LADDER_REPEAT             0x01      // auto-repeat command while held, ignored with a holdCommand
+
+struct LadderButton {
+	uint16_t  low, high;                      // ADC window (0-1023) this button reads in
+	uint8_t   command;                        // default INPUT_PRESS binding
+	uint8_t   holdCommand;                    // default INPUT_LONG_PRESS binding, 0 = no separate hold action
+	uint8_t   flags;
+	};
+
+class ButtonLadder {
+	public:
+		ButtonLadder(){};
+		~ButtonLadder(){};
+		void begin(uint8_t pin,const LadderButton *table,uint8_t count);
+		bool sample(InputEvent &event);         // true if event was filled in
+		void noteEnqueued();                    // call right after routing what sample() returned, tracks latency
+		void report();
+		void resetStats();
+	private:
+		uint8_t             _pin=A0;
+		const LadderButton *_table=NULL;
+		uint8_t             _count=0;
+		uint16_t            _level=0;
+		int8_t              _candidate=-1, _pressed=-1;
+		uint8_t             _stable=0;
+		bool                _holdSent=false;
+		uint32_t            _candidateUs=0, _eventUs=0;
+		uint32_t            _pressMillis=0, _repeatMillis=0;
+		uint32_t            _events=0, _lastLatencyUs=0, _maxLatencyUs=0;
+
+		int8_t _classify(uint16_t level);
+	};
+
+#endif // BUTTONLADDER_H
@@ -0,0 +1,138 @@
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+//
+// Ring buffer of pending radio commands, packed two per byte.
+//
+// Command codes are small (VOLUMEUP..TRIPLECLICK all fit in a nibble) so each slot only needs 4 bits,
+// a 200 deep queue costs 100 bytes of .bss for the commands instead of the 800 the old int[] did.  Capacity is a
+// template parameter so a build can trade RAM for burst depth (QUEUEMAXSIZE in RadioProfile.h, overridable from
+// build_flags).
+//
+// All producers (Pulse* via the InputRouter, from pt1/pt3 and PushButton::service()) and the consumer (pt2) run in
+// loop() context, no ISR pushes.  The head/tail/count updates and the nibble read-modify-write are still done with
+// interrupts masked so a producer can be moved into an ISR without reworking the queue; the native race harness
+// (test/test_queue_race) checks that.  When the queue is full the new command is dropped (and counted) rather than
+// overwriting the oldest one.
+//
+// Every entry also carries its enqueue time so the dispatcher can drop commands that have been waiting longer than
+// their TTL.  The stamp is one byte of TickMs ticks (another 200 bytes at the default depth), so an age is only good
+// up to 256 ticks, the caller has to make sure nothing waits that long (RadioProfile.h COMMAND_AGE_TICK_MS).
+//
+#include <Arduino.h>
+
+#ifdef QUEUE_STRESS
+// the race harness (-DQUEUE_STRESS, [env:native]) fires its simulated ISR from these points, every spot an
+// interrupt could land
+extern void (*volatile QueueStressHook)();
+#define QUEUE_PREEMPT_POINT()   do { if (QueueStressHook) QueueStressHook(); } while(0)
+#else
+#define QUEUE_PREEMPT_POINT()   do { } while(0)
+#endif
+
+#ifdef QUEUE_STRESS_UNMASKED
+// harness self check ([env:native_unmasked]): no masking, and a preempt point between the individual steps of each
+// update, the harness has to find the race this opens
+#define QUEUE_MASK()            0
+#define QUEUE_UNMASK(ps)        ((void)(ps))
+#define QUEUE_STEP_POINT()      QUEUE_PREEMPT_POINT()
+#else
+#define QUEUE_MASK()            xt_rsil(15)
+#define QUEUE_UNMASK(ps)        xt_wsr_ps(ps)
+#define QUEUE_STEP_POINT()      do { } while(0)        // masked, nothing can land in here
+#endif
+
+#define COMMANDQUEUE_EMPTY 0          // pop()/peek() value when there is nothing queued, never a valid command
+#define COMMANDQUEUE_MASK  0x0F
+
+template <uint16_t Capacity,uint8_t TickMs>
+class CommandQueue {
+	public:
+		CommandQueue(){ clear(); };
+		~CommandQueue(){};
+
+		void clear(){
+			uint32_t savedPS=xt_rsil(15);
+			_head=0;
+			_tail=0;
+			_count=0;
+			_dropped=0;
+			xt_wsr_ps(savedPS);
+		}
+
+		bool push(uint8_t cmd){
+			bool     stored=false;
+			uint16_t head, count;
+			QUEUE_PREEMPT_POINT();
+			uint32_t savedPS=QUEUE_MASK();
+			if (_count < Capacity){
+				head=_head;
+				QUEUE_STEP_POINT();
+				_put(head,cmd);
+				QUEUE_STEP_POINT();
+				_stamps[head]=_tick();
+				_head=_next(head);
+				QUEUE_STEP_POINT();
+				count=_count;
+				QUEUE_STEP_POINT();
+				_count=count+1;
+				stored=true;
+			}
+			else
+				_dropped++;
+			QUEUE_UNMASK(savedPS);
+			QUEUE_PREEMPT_POINT();
+			return stored;
+		}
+
+		uint8_t pop(uint16_t *ageMs=NULL){
+			uint8_t  cmd=COMMANDQUEUE_EMPTY;
+			uint16_t tail, count;
+			QUEUE_PREEMPT_POINT();
+			uint32_t savedPS=QUEUE_MASK();
+			if (_count){
+				tail=_tail;
+				QUEUE_STEP_POINT();
+				cmd=_get(tail);
+				if (ageMs)
+					*ageMs=(uint8_t)(_tick()-_stamps[tail])*(uint16_t)TickMs;
+				QUEUE_STEP_POINT();
+				_tail=_next(tail);
+				QUEUE_STEP_POINT();
+				count=_count;
+				QUEUE_STEP_POINT();
+				_count=count-1;
+			}
+			QUEUE_UNMASK(savedPS);
+			QUEUE_PREEMPT_POINT();
+			return cmd;
+		}
+
+		uint8_t peek() const { return _count ? _get(_tail):COMMANDQUEUE_EMPTY; }
+		uint16_t count() const { return _count; }
+		bool empty() const { return _count == 0; }
+		uint32_t dropped() const { return _dropped; }
+		static uint16_t capacity() { return Capacity; }
+
+	private:
+		uint8_t           _slots[(Capacity + 1) / 2];
+		uint8_t           _stamps[Capacity];
+		volatile uint16_t _head, _tail, _count;
+		volatile uint32_t _dropped;
+
+		static uint8_t _tick(){ return millis()/TickMs; }
+		static uint16_t _next(uint16_t i){ return (i + 1 == Capacity) ? 0:i + 1; }
+
+		uint8_t _get(uint16_t i) const {
+			uint8_t b=_slots[i >> 1];
+			return (i & 1) ? (b >> 4):(b & COMMANDQUEUE_MASK);
+		}
+
+		void _put(uint16_t i,uint8_t cmd){
+			uint8_t b=_slots[i >> 1];
+			QUEUE_STEP_POINT();             // the neighbour nibble is read here and written back below
+			cmd&=COMMANDQUEUE_MASK;
+			_slots[i >> 1]=(i & 1) ? ((b & COMMANDQUEUE_MASK) | (cmd << 4)):((b & 0xF0) | cmd);
+		}
+	};
+
+#endif // COMMANDQUEUE_H
@@ -0,0 +1,33 @@
+#ifndef IDLEGOVERNOR_H
+#define IDLEGOVERNOR_H
+//
+// Puts loop() to sleep while there is nothing queued and no dispatcher timer running.
+//
+// sleep() parks the loop task in delay(), which hands the CPU back to the SDK so it can idle (waiti) instead of
+// spinning the protothreads, the radio is already off (preinit) so the chip sits in modem sleep.  A wake() from an
+// ISR cuts the sleep short, otherwise it ends after the slice.  Wake-up latency (how late the loop resumed against
+// the slice end or the wake() request) is tracked so the slice can be tuned without hurting responsiveness.
+//
+#include <Arduino.h>
+
+#ifndef IDLE_MAX_SLICE_MS
+#define IDLE_MAX_SLICE_MS 10          // longest single sleep, also bounds how late a polled input (ladder) is seen
+#endif
+
+class IdleGovernor {
+	public:
+		IdleGovernor(){};
+		~IdleGovernor(){};
+		void sleep(uint16_t ms=IDLE_MAX_SLICE_MS);
+		void wake();                                // ISR safe
+		void report();
+		void resetStats();
+	private:
+		volatile bool     _sleeping=false;
+		volatile uint32_t _wakeRequestUs=0;
+		uint32_t          _sleeps=0, _earlyWakes=0;
+		uint32_t          _lastLatencyUs=0, _maxLatencyUs=0;
+		uint32_t          _sleptUs=0, _statsStartUs=0;
+	};
+
+#endif // IDLEGOVERNOR_H
@@ -0,0 +1,75 @@
+#ifndef INPUTROUTER_H
+#define INPUTROUTER_H
+//
+// Routes typed input events (which control, what happened, how much, when) to queued radio commands.
+//
+// The bindings are a flat [source][event type] table of command codes, so routing an event is one indexed load
+// whatever the number of controls, and adding a control is a new InputSource plus bind() calls, not another if in
+// the hot loop.  A source with several buttons (the steering wheel ladder) gives each one its own row, picked by
+// the event's index.  route() is main context only, the sink queues through Pulse* which is flash code and logs over
+// Serial, so an ISR (the button) just timestamps and leaves the event to loop().
+//
+#include <Arduino.h>
+
+enum InputSource {
+	INPUT_ENCODER0,                           // panel encoder (D1/D2)
+	INPUT_ENCODER1,                           // optional second encoder, -DENCODER2_A/-DENCODER2_B
+	INPUT_BUTTON0,                            // encoder push switch (D3)
+	INPUT_LADDER,                             // steering wheel ladder, -DLADDER_ENABLED, index = button in its table
+	INPUT_SOURCES
+	};
+
+#define INPUT_LADDER_BUTTONS 8                // rows for INPUT_LADDER, a vehicle table can't have more buttons
+
+enum InputEventType {
+	INPUT_STEP_UP,                            // magnitude = detents
+	INPUT_STEP_DOWN,
+	INPUT_PRESS,                              // released before INPUT_LONG_PRESS_MS
+	INPUT_LONG_PRESS,
+	INPUT_EVENT_TYPES
+	};
+
+#define INPUT_LONG_PRESS_MS 700
+
+struct InputEvent {
+	uint8_t   source;
+	uint8_t   type;
+	uint8_t   index;                          // which button of INPUT_LADDER, 0 for every other source
+	uint8_t   magnitude;                      // how many times the bound command is queued
+	uint32_t  timestamp;                      // millis()
+	};
+
+class InputRouter {
+	public:
+		typedef void (*Sink)(uint8_t cmd);
+
+		InputRouter(){};
+		~InputRouter(){};
+		void begin(Sink sink){ _sink=sink; }
+		void bind(uint8_t source,uint8_t type,uint8_t cmd,uint8_t index=0){
+			uint8_t row=_row(source,index);
+
+			if (row < INPUT_ROWS && type < INPUT_EVENT_TYPES)
+				_table[row][type]=cmd;
+		}
+		uint8_t route(const InputEvent &e);     // command routed, 0 if the event isn't bound
+		uint32_t routed() const { return _routed; }
+		uint32_t unbound() const { return _unbound; }
+	private:
+		Sink              _sink=NULL;
+		static const uint8_t INPUT_ROWS=INPUT_SOURCES+INPUT_LADDER_BUTTONS-1;
+
+		uint8_t           _table[INPUT_ROWS][INPUT_EVENT_TYPES]={};
+		volatile uint32_t _routed=0, _unbound=0;
+
+		// ladder buttons past the first take the rows after the last source, INPUT_ROWS if there's no such row
+		static uint8_t _row(uint8_t source,uint8_t index){
+			if (!index)
+				return source < INPUT_SOURCES ? source:INPUT_ROWS;
+			if (source != INPUT_LADDER || index >= INPUT_LADDER_BUTTONS)
+				return INPUT_ROWS;
+			return INPUT_SOURCES+index-1;
+		}
+	};
+
+#endif // INPUTROUTER_H
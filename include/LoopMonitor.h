@@ -0,0 +1,51 @@
+#ifndef LOOPMONITOR_H
+#define LOOPMONITOR_H
+//
+// Times every loop() pass and every protothread resume.
+//
+// Pass durations go into a log2 histogram (bucket n holds passes of 2^(n-1)..2^n-1 us).  A protothread resume that
+// runs longer than LOOP_STALL_US is logged with the thread, the line it resumed from and the line it blocked/yielded
+// at, both read from the lc-switch continuation (pt->lc holds __LINE__ of the last PT_WAIT/PT_YIELD), so the
+// offending stretch of code is bracketed exactly.  Blocking code in loop() that isn't a protothread (the serial
+// reports) is bracketed the same way as a named section, beginThread(NULL) / endThread(LOOP_SECTION_..., NULL).
+// endLoop() is the supervised point that feeds the watchdog: it's only reached once every thread and section has
+// handed control back, so the pass time includes all of them.
+//
+#include <Arduino.h>
+#include "pt.h"
+
+#ifndef LOOP_STALL_US
+#define LOOP_STALL_US             20000     // a resume longer than this is recorded as a stall
+#endif
+#define LOOP_HISTOGRAM_BUCKETS    18        // last bucket catches everything >= 65ms
+#define LOOP_STALL_LOG            8         // most recent stalls kept
+#define LOOP_SECTION_TRACE        10        // X9C trace report / VCD dump
+#define LOOP_SECTION_REPORT       11        // periodic stats block
+
+struct LoopStall {
+	uint32_t  at;                             // millis() when the resume started
+	uint32_t  duration;                       // us
+	uint8_t   thread;
+	lc_t      fromLine, toLine;
+	};
+
+class LoopMonitor {
+	public:
+		LoopMonitor(){};
+		~LoopMonitor(){};
+		void beginLoop();
+		void endLoop();
+		void beginThread(struct pt *pt);        // NULL for a section
+		void endThread(uint8_t thread,struct pt *pt);
+		void report();
+		void resetStats();
+	private:
+		uint32_t  _loopStart=0, _threadStart=0;
+		lc_t      _threadFrom=0;
+		uint32_t  _histogram[LOOP_HISTOGRAM_BUCKETS]={0};
+		uint32_t  _maxLoopUs=0;
+		uint32_t  _stalls=0;
+		LoopStall _stallLog[LOOP_STALL_LOG];
+	};
+
+#endif // LOOPMONITOR_H
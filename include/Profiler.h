@@ -0,0 +1,71 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+//
+// CPU accounting from the ESP8266 cycle counter (1 cycle = 12.5ns at 80MHz).
+//
+// Build with -DPROFILE_ENABLED to turn it on, otherwise every PROFILE_ macro collapses to the bare statement and
+// nothing here is compiled in.  Thread time is measured around each protothread resume in loop(); X9C time is
+// measured around each pot operation and charged to the command being presented, serial time around the log
+// prints.  X9C and serial time are nested, they are also counted in the thread that made the call.
+//
+#include <Arduino.h>
+
+enum ProfileTask {
+	PROFILE_ENCODER,                          // pt1
+	PROFILE_DISPATCH,                         // pt2
+	PROFILE_X9C,
+	PROFILE_SERIAL,
+	PROFILE_LADDER,                           // pt3, steering wheel buttons
+	PROFILE_TASKS
+	};
+
+#define PROFILE_COMMANDS 16                 // one slot per (nibble) command code
+
+#ifdef PROFILE_ENABLED
+
+struct ProfileSlot {
+	uint64_t  cycles;
+	uint32_t  calls;
+	uint32_t  maxCycles;
+	};
+
+class Profiler {
+	public:
+		Profiler(){};
+		~Profiler(){};
+		void add(uint8_t task,uint32_t cycles){ _add(_tasks[task],cycles); }
+		void addCommand(uint8_t cmd,uint32_t cycles){ _add(_commands[cmd % PROFILE_COMMANDS],cycles); }
+		void report();
+		void resetStats();
+	private:
+		ProfileSlot _tasks[PROFILE_TASKS]={};
+		ProfileSlot _commands[PROFILE_COMMANDS]={};
+		uint32_t    _startMillis=0;
+
+		// masked, the 64 bit add is two stores and would tear if a PROFILE_ macro ran from an ISR
+		static void _add(ProfileSlot &slot,uint32_t cycles){
+			uint32_t savedPS=xt_rsil(15);
+			slot.cycles+=cycles;
+			slot.calls++;
+			if (cycles > slot.maxCycles)
+				slot.maxCycles=cycles;
+			xt_wsr_ps(savedPS);
+		}
+	};
+
+extern Profiler profiler;
+
+#define PROFILE_RUN(task,stmt)      do { uint32_t _profStart=ESP.getCycleCount(); stmt; profiler.add(task,ESP.getCycleCount()-_profStart); } while(0)
+#define PROFILE_COMMAND(cmd,stmt)   do { uint32_t _profStart=ESP.getCycleCount(); stmt; uint32_t _profCycles=ESP.getCycleCount()-_profStart; \
+                                         profiler.add(PROFILE_X9C,_profCycles); profiler.addCommand(cmd,_profCycles); } while(0)
+#define PROFILE_REPORT()            do { profiler.report(); profiler.resetStats(); } while(0)
+
+#else
+
+#define PROFILE_RUN(task,stmt)      do { stmt; } while(0)
+#define PROFILE_COMMAND(cmd,stmt)   do { stmt; } while(0)
+#define PROFILE_REPORT()            do { } while(0)
+
+#endif // PROFILE_ENABLED
+
+#endif // PROFILER_H
@@ -0,0 +1,40 @@
+#ifndef PUSHBUTTON_H
+#define PUSHBUTTON_H
+//
+// Debounced push switch (the encoder's, to ground with the pull-up) routed as INPUT_PRESS / INPUT_LONG_PRESS.
+//
+// Both edges interrupt into an IRAM ISR that only times the press: an edge within debounceMs of the last accepted
+// one, or one that doesn't change the state, is bounce.  Routing queues through Pulse* (flash, Serial) so it is left
+// to service() in loop(), which also resyncs the state from the pin once it has been stable for the window, an edge
+// dropped inside it would otherwise leave the state stuck (a tap shorter than the window, a press right after a
+// release).  A press held for INPUT_LONG_PRESS_MS or more is a long press, reported at release like a short one.
+//
+#include <Arduino.h>
+#include "InputRouter.h"
+
+#ifndef BUTTON_DEBOUNCE_MS
+#define BUTTON_DEBOUNCE_MS 30                 // ms the switch has to stay put before an edge counts
+#endif
+
+class PushButton {
+	public:
+		PushButton(){};
+		~PushButton(){};
+		void begin(uint8_t pin,InputRouter *router,uint8_t source,uint16_t debounceMs=BUTTON_DEBOUNCE_MS,void (*onRelease)()=NULL);
+		void service();                         // loop() context, routes a release the ISR timed
+		bool pending() const { return _released; }  // a release service() hasn't routed yet
+	private:
+		uint8_t                 _pin=0;
+		InputRouter            *_router=NULL;
+		uint8_t                 _source=INPUT_BUTTON0;
+		uint16_t                _debounceMs=BUTTON_DEBOUNCE_MS;
+		void                  (*_onRelease)()=NULL;
+		volatile bool           _down=false, _released=false;
+		volatile unsigned long  _edgeMillis=0, _downMillis=0, _heldMillis=0;
+
+		static void _isr(void *arg);
+		void _edge();
+		void _set(bool down,unsigned long now);
+	};
+
+#endif // PUSHBUTTON_H
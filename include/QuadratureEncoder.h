@@ -0,0 +1,63 @@
+#ifndef QUADRATUREENCODER_H
+#define QUADRATUREENCODER_H
+//
+// Interrupt driven quadrature decoder for the detented panel encoder(s).
+//
+// Both pins interrupt on CHANGE into an IRAM ISR that reads them straight from the GPIO input register and looks
+// the (previous,current) state pair up in a 16 entry transition table (+1, -1, or 0 for no-change/invalid).
+// Transitions are summed and a count is only taken when the encoder comes back to a rest state having moved at
+// least half way, so contact bounce at a detent can't count twice.  Every edge is decoded, so the state follows the
+// pins through a glitch and its return cancels out.  minEdgeUs applies to the rest level instead: the count is held
+// pending until the rest has seen no edge for minEdgeUs (the next edge or read() checks), an edge inside that
+// window (counted as a glitch) cancels it.  The ISR times itself with the cycle counter (count / max / average).
+//
+// QUAD_STEPS_PER_COUNT picks the rest states.  2 (default) rests at both 00 and 11, one count per half cycle: a
+// half cycle encoder gives one count per detent, a full cycle one (e.g. KY-040) two, which is what the old
+// Encoder library read() with pt1's '> 1' threshold gave.  4 rests at 11 only, one count per full cycle.
+//
+// -DQUAD_REFERENCE_DECODER swaps the table decode for the Encoder library's update() state machine inside the same
+// ISR and instrumentation, so isr_cyc from the two builds compares the decoders on the target.
+//
+#include <Arduino.h>
+
+#define QUAD_REST         3                 // both pins high (pull-ups) when sitting in a detent
+#define QUAD_REST_HALF    0                 // both low, the other rest state with QUAD_STEPS_PER_COUNT 2
+#ifndef QUAD_STEPS_PER_COUNT
+#define QUAD_STEPS_PER_COUNT 2
+#endif
+#if QUAD_STEPS_PER_COUNT != 2 && QUAD_STEPS_PER_COUNT != 4
+#error "QUAD_STEPS_PER_COUNT must be 2 (rest at 00 and 11) or 4 (rest at 11)"
+#endif
+#ifndef QUAD_MIN_EDGE_US
+#define QUAD_MIN_EDGE_US  100               // a rest has to stay quiet this long to count, a fast spin is still > 1ms per edge
+#endif
+
+class QuadratureEncoder {
+	public:
+		QuadratureEncoder(){};
+		~QuadratureEncoder(){};
+		void begin(uint8_t pinA,uint8_t pinB,uint16_t minEdgeUs=QUAD_MIN_EDGE_US,void (*onDetent)()=NULL);
+		long read();                            // counts, see QUAD_STEPS_PER_COUNT, commits a settled pending one
+		void report();
+		void resetStats();
+	private:
+		uint8_t           _pinA=0, _pinB=0;
+		uint32_t          _minEdgeCycles=0;
+		void            (*_onDetent)()=NULL;
+		volatile long     _detents=0;
+		volatile uint8_t  _state=QUAD_REST;
+		volatile int8_t   _steps=0;
+		volatile int8_t   _pending=0;             // +-1 reached a rest, not settled for the window yet
+#ifdef QUAD_REFERENCE_DECODER
+		volatile long     _position=0;            // library style quarter steps, read() is this / QUAD_STEPS_PER_COUNT
+#endif
+		volatile uint32_t _lastEdge=0;
+		volatile uint32_t _edges=0, _glitches=0, _invalid=0;
+		volatile uint32_t _isrCalls=0, _isrMaxCycles=0, _isrCycles=0;
+
+		static void _isr(void *arg);
+		void _edge();
+		void _commit(){ _detents+=_pending; _steps=0; _pending=0; }
+	};
+
+#endif // QUADRATUREENCODER_H
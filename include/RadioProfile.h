@@ -0,0 +1,61 @@
+#ifndef RADIOPROFILE_H
+#define RADIOPROFILE_H
+//
+// Head unit profile: the commands we can queue, the resistance each one presents, and the timing the unit needs.
+// Kept free of Arduino includes so TimingModel.h (and the build's timing report) can use it on the host.
+//
+#include <stdint.h>
+
+// 20200714 -- you must now place the defines for anything that causes the Pioneer VolumeScreen to come up first and contiguous so that SCREENRANGE is < all of them
+#define VOLUMEUP      1
+#define VOLUMEDOWN    2
+#define MUTE          3         // mute can be implemented as the button MUTE or PLAY/PAUSE which would allow Navigation to continue, I usually opt for that method
+#define SCREENRANGE   4
+
+#define TRACKFF       4
+#define TRACKPV       5
+#define TRIPLECLICK   6       // unsure what this does, mostly testing right now
+
+// in the case of the X9C pot, its a percentage and the 104 is 100K with 100 steps so each step is 1000 Ohm or 1K so you just set the percentage directly
+//
+
+#define REST_VOLUMEUP                              16
+#define REST_VOLUMEDOWN                            24
+#define REST_TRACKFF                               7
+#define REST_MUTE                                  3.5
+#define REST_TRACKPV                               10
+#define REST_TRIPLECLICK                           0
+
+// time vars
+static constexpr int MinSliceDelay                 = 1;
+static constexpr int DeBounceDelay                 = 10;          // this is hardware/software loop centric, for my setup and loop() 1 seems to be working well
+
+
+// Threading times                                              //  libraries scheduler seem to need different CPUs, and protothread seemed to involved, so just did a simple wait schedule with anti-stravation
+static constexpr int WaitForUnitToComplete         = 41;         // so far it looks like the Pioneer might need 40msec to respond to the event
+static constexpr int WaitForDisplayTime            = 850;        // was 650        // this should be the minimum time to display the screen
+static constexpr int WaitTimeForBetweenScreens     = 4100;       // this should be the minimum time for the volume screen to remove after no other commands have been sent
+
+// how long a queued command stays worth playing, ms, indexed by command code (0 = never expires).  Volume steps go
+// stale fastest: by the time a backed up queue gets to them the user has stopped turning and they'd only overshoot.
+#define COMMAND_CODES 8
+static constexpr uint16_t CommandTTL[COMMAND_CODES] = {
+  0,                                                            // (empty)
+  1500,                                                         // VOLUMEUP
+  1500,                                                         // VOLUMEDOWN
+  3000,                                                         // MUTE
+  3000,                                                         // TRACKFF
+  3000,                                                         // TRACKPV
+  3000,                                                         // TRIPLECLICK
+  0
+};
+
+// queued commands are stamped with an 8 bit count of these, 256 ticks (8.2s) has to cover the longest a command can
+// wait before it's played or dropped, TimingModel.h checks that against boundedResponseUs() plus a stall
+#define COMMAND_AGE_TICK_MS 32
+
+#ifndef QUEUEMAXSIZE
+#define               QUEUEMAXSIZE  200                         // burst depth, override with -DQUEUEMAXSIZE=n in build_flags to trade RAM
+#endif
+
+#endif // RADIOPROFILE_H
@@ -0,0 +1,84 @@
+#ifndef RADIOTASKS_H
+#define RADIOTASKS_H
+//
+// The command queue, its producers (Pulse*) and the protothreads that feed and work it.
+//
+// All of a task's state lives in its struct (nothing function static) so any number of instances can run side by
+// side (e.g. a dispatcher per output) and a fresh one is just another ...TaskInit().  main.cpp only wires instances
+// to pins and runs them from loop(), so the tasks build without setup()/loop().
+//
+#include <Arduino.h>
+#include "pt.h"
+#include "RadioProfile.h"
+#include "CommandQueue.h"
+#include "X9C.h"
+#include "QuadratureEncoder.h"
+#include "ButtonLadder.h"
+#include "InputRouter.h"
+
+// ProtoThread Queue
+typedef CommandQueue<QUEUEMAXSIZE, COMMAND_AGE_TICK_MS> RadioQueue;
+extern RadioQueue Queue;
+
+#ifdef X9C_PINGPONG
+typedef X9CPair OutputPot;  //  2 x 100 KΩ behind an analog switch
+#else
+typedef X9C OutputPot;  //  100 KΩ
+#endif
+
+struct EncoderTask                                              // pt1, turns encoder detents into step events
+{
+  struct pt             pt;
+  QuadratureEncoder    *encoder                        = NULL;
+  InputRouter          *router                         = NULL;
+  uint8_t               source                         = INPUT_ENCODER0;
+  unsigned long         timestamp                      = 0;
+  long                  counter                        = 0;
+  long                  lastVolumeCount                = 0;
+};
+
+struct DispatchTask                                             // pt2, works the queue onto a pot (the POT setter)
+{
+  struct pt             pt;
+  RadioQueue           *queue                          = NULL;
+  OutputPot            *pot                            = NULL;
+  unsigned long         timestamp                      = 0;
+  uint16_t              Command                        = 0;
+  unsigned long         PreviousCommandTimeStamp       = 0;
+  bool                  WaitForDisplay                 = false;
+  unsigned long         TimeWhenInQueue                = 0;
+  bool                  InsideAQueueProcess            = false;
+  int                   TempCommand                    = 0;
+  uint16_t              Age                            = 0;         // ms TempCommand sat in the queue
+  uint32_t              Expired[COMMAND_CODES]         = {};        // dropped past their TTL, per command code
+  int                   LoopOfThread                   = 0;
+  int                   CurLimit                       = 0;
+  bool                  Busy                           = false;     // working a batch (or waiting on one of its timers)
+};
+
+struct LadderTask                                               // pt3, steering wheel button ladder
+{
+  struct pt             pt;
+  ButtonLadder         *ladder                         = NULL;
+  InputRouter          *router                         = NULL;
+  unsigned long         timestamp                      = 0;
+};
+
+void PulseVolumeUp();
+void PulseVolumeDown();
+void PulseTrackForward();
+void PulseTrackBack();
+void PulseMute();
+void PulseTripleClick();
+void PulseCommand(uint8_t cmd);                                 // queue a command code, the InputRouter sink
+uint8_t CommandRest(uint8_t cmd);
+
+void EncoderTaskInit(struct EncoderTask *t, QuadratureEncoder *encoder, InputRouter *router, uint8_t source);
+int protothread1(struct EncoderTask *t);
+void DispatchTaskInit(struct DispatchTask *t, RadioQueue *queue, OutputPot *pot);
+int protothread2(struct DispatchTask *t);
+uint16_t DispatchTaskExpire(struct DispatchTask *t);
+void LadderTaskInit(struct LadderTask *t, ButtonLadder *ladder, InputRouter *router);
+int protothread3(struct LadderTask *t);
+
+#endif // RADIOTASKS_H
@@ -0,0 +1,103 @@
+#ifndef TIMINGMODEL_H
+#define TIMINGMODEL_H
+//
+// Compile time worst case timing of the command path, built from the head unit profile (RadioProfile.h), the X9C
+// stepping in X9C::_stepPot and the waits in protothread2.  Anything that changes those numbers (a new head unit
+// profile, a deeper queue, longer waits) is checked against the latency budgets below and the build stops with a
+// static_assert if they're blown.  scripts/timing_report.py compiles this on the host and prints the figures.
+//
+// All times are in us.  A PT_WAIT_UNTIL(millis() - t > n) waits up to n + 1 ms once millis() granularity is counted.
+//
+#include "RadioProfile.h"
+#include "X9C.h"
+
+#ifndef LATENCY_BUDGET_COMMAND_MS
+#define LATENCY_BUDGET_COMMAND_MS   1000    // one command incl. the volume screen wait, from dequeue to ready for the next
+#endif
+#ifndef LATENCY_BUDGET_QUEUE_MS
+#define LATENCY_BUDGET_QUEUE_MS     20000   // draining a completely full queue
+#endif
+
+#define X9C_GPIO_WRITE_US           1       // digitalWrite() on the ESP8266, rounded up
+#define X9C_PULSE_US                (2 + 2 * X9C_GPIO_WRITE_US)     // one INC low/high with its two 1us delays
+#define X9C_SETTLE_US               100     // _stepPot's tIW delay
+#define X9C_ADC_READ_US             100     // one analogRead() (readback verify)
+
+namespace TimingModel {
+
+constexpr uint32_t waitUs(uint32_t ms){ return (ms + 1) * 1000UL; }
+
+// _stepPot: U/D write and its tDI delay, CS write, the pulses (capped at X9C_MAX), the settle
+constexpr uint32_t stepPotUs(uint32_t steps){
+	return 2 * X9C_GPIO_WRITE_US + X9C_TDI_US + (steps > X9C_MAX ? X9C_MAX:steps) * X9C_PULSE_US + X9C_SETTLE_US;
+}
+
+constexpr uint32_t deselectUs(){ return 3 * X9C_GPIO_WRITE_US; }
+
+constexpr uint32_t setPotUs(uint32_t pos){ return stepPotUs(X9C_MAX + 1) + stepPotUs(pos) + deselectUs(); }
+
+constexpr uint32_t setPotMaxUs(){ return stepPotUs(X9C_MAX + 1) + deselectUs(); }
+
+// -DX9C_READBACK: worst case a move goes end to end, fails its verify and re-homes
+constexpr uint32_t moveToUs(uint32_t pos){
+	return stepPotUs(X9C_MAX) + deselectUs() + X9C_READBACK_SAMPLES * X9C_ADC_READ_US + setPotUs(pos);
+}
+
+constexpr uint32_t max2(uint32_t a,uint32_t b){ return a > b ? a:b; }
+
+constexpr uint32_t largestRest(){
+	return max2(max2(max2((uint32_t)REST_VOLUMEUP,(uint32_t)REST_VOLUMEDOWN),max2((uint32_t)REST_TRACKFF,(uint32_t)REST_TRACKPV)),
+	            (uint32_t)REST_MUTE);
+}
+
+// -DX9C_PINGPONG: the press stages the hidden pot (normally already done, worst case a full setPot) and flips, the
+// release flips back and stages the next command's rest on the pot that just went hidden, a full setPot too
+#if defined(X9C_PINGPONG)
+constexpr uint32_t pressUs(uint32_t rest){ return setPotUs(rest) + X9C_GPIO_WRITE_US; }
+constexpr uint32_t releaseUs(){ return X9C_GPIO_WRITE_US + setPotUs(largestRest()); }
+#elif defined(X9C_READBACK)
+constexpr uint32_t pressUs(uint32_t rest){ return moveToUs(rest); }
+constexpr uint32_t releaseUs(){ return moveToUs(X9C_MAX); }
+#else
+constexpr uint32_t pressUs(uint32_t rest){ return setPotUs(rest); }
+constexpr uint32_t releaseUs(){ return setPotMaxUs(); }
+#endif
+
+// press (present + wait) and release (back to max + wait), plus the screen wait when the command opens the screen
+constexpr uint32_t commandUs(uint32_t rest,bool opensScreen){
+	return pressUs(rest) + waitUs(WaitForUnitToComplete) + releaseUs() + waitUs(WaitForUnitToComplete) +
+	       (opensScreen ? waitUs(WaitForDisplayTime) : 0);
+}
+
+constexpr uint32_t worstCommandUs(){ return commandUs(largestRest(),true); }
+
+constexpr uint32_t longestTTLus(uint8_t i=0){
+	return i >= COMMAND_CODES ? 0:max2(CommandTTL[i] * 1000UL,longestTTLus(i + 1));
+}
+
+// with TTL dropping a command is either started within its TTL or discarded, so this bounds input to response
+constexpr uint32_t boundedResponseUs(){ return longestTTLus() + worstCommandUs(); }
+
+// a loop() pass longer than this (a VCD dump, a blocking report) expires everything queued before it, it's all past
+// its TTL anyway, see DispatchTaskExpire()
+constexpr uint32_t stallExpireUs(){ return longestTTLus(); }
+
+// a full queue is one batch: the screen wait happens at most once, then every command back to back
+constexpr uint32_t fullQueueUs(uint32_t depth){
+	return waitUs(MinSliceDelay) + waitUs(WaitForDisplayTime) + depth * commandUs(largestRest(),false);
+}
+
+}
+
+static_assert(TimingModel::worstCommandUs() <= LATENCY_BUDGET_COMMAND_MS * 1000UL,
+              "worst case single command exceeds LATENCY_BUDGET_COMMAND_MS");
+static_assert(TimingModel::fullQueueUs(QUEUEMAXSIZE) <= LATENCY_BUDGET_QUEUE_MS * 1000UL,
+              "draining a full queue exceeds LATENCY_BUDGET_QUEUE_MS, lower QUEUEMAXSIZE or the waits");
+// each pop is within a command's time of the one before, which was played inside its TTL (or dropped), so nothing
+// waits longer than boundedResponseUs() while loop() keeps running.  A pass that stalls on top of that delays the
+// pop by up to stallExpireUs(), a longer one clears the queue (loop()'s stall guard), so the 8 bit queue stamps
+// can't wrap on a live entry
+static_assert(TimingModel::boundedResponseUs() + TimingModel::stallExpireUs() < 256UL * COMMAND_AGE_TICK_MS * 1000UL,
+              "a command can outlive the queue's 8 bit age stamp, raise COMMAND_AGE_TICK_MS or lower the TTLs");
+
+#endif // TIMINGMODEL_H
@@ -28,14 +28,42 @@ SOFTWARE.
 //		setPotMin will give abt 220R - 330R between these pins
 //      setPotMax should give abt 100k
 //
+#ifdef ARDUINO
 #include <Arduino.h>
+#else
+#include <stdint.h>                         // host side users (TimingModel report) only need the limits below
+#endif
 
 #define X9C_UP LOW
 #define X9C_DOWN HIGH
 #define X9C_MAX 99
+#define X9C_UNKNOWN 0xFF                    // wiper position not known
+#define X9C_TDI_US 3                        // U/D to INC setup (datasheet tDI, 2.9us)
+#define X9C_NO_READBACK 0xFF                // no ADC pin given to setReadback()
+#define X9C_READBACK_SAMPLES 4              // analogRead()s averaged per verify
+#define X9C_READBACK_MIN_TOLERANCE 2        // ADC counts, floor under the half step window (noise)
+#define X9C_READBACK_CAL_POS 80             // upper calibration point, max itself can clip at A0's 3.2V full scale
+#ifndef X9C_KOHM
+#define X9C_KOHM 100                        // x9c104
+#endif
+#ifndef X9C_READBACK_PULLUP_KOHM
+#define X9C_READBACK_PULLUP_KOHM 10         // head unit's pull-up on its steering wheel input, measure yours
+#endif
 //
 // stepPot explicilty does NOT save to NVRAM - allows reboot to old NVRAM value, with minor runtime tweaks
 //
+// the no save deselect drops INC while CS is still low, that edge moves the wiper one more step in the last
+// direction, so setPot(pos,false) lands on pos+1 and position() keeps track of where the wiper really is.
+//
+// optional readback: nothing but the head unit may drive or load the presented leg (Vh to the head unit's ground, Vw
+// to its input, Vl left open), so A0 reads the wiper through a unity gain buffer (rail to rail op amp on 3V3, its
+// input draws nA where A0's own 220K/100K divider would sit in parallel with the leg).  The level is then set by the
+// head unit's pull-up (X9C_READBACK_PULLUP_KOHM) against the leg, so setReadback() measures home and
+// X9C_READBACK_CAL_POS and verify() expects that pull-up curve between them, within half a step of the neighbouring
+// positions.  The curve flattens towards max, with a 10K pull-up single steps are only told apart up to about 40,
+// which covers every rest position.  moveTo() then steps incrementally from the known position to where setPot()
+// would have landed, verifies the result, and only re-homes (the full sweep setPot always does) on a mismatch.
+//
 class X9C {
 	public:
 		X9C(){};
@@ -45,12 +73,54 @@ class X9C {
 		void setPotMax(bool save=true);
 	  	void setPotMin(bool save=true);
 		void trimPot(uint8_t amt,uint8_t dir,bool save=true);
+		void setReadback(uint8_t adc);          // calibrates, the wiper is left at max (no store)
+		bool moveTo(uint8_t pos,bool save=true);    // false when readback found a mismatch and it re-homed
+		bool verify(uint8_t pos);
+		uint8_t position() const { return _pos; }
+		uint32_t verifies() const { return _verifies; }
+		uint32_t mismatches() const { return _mismatches; }
 	private:
 		uint8_t _cs, _inc, _ud;
+		uint8_t _pos=X9C_UNKNOWN;
+		uint8_t _adc=X9C_NO_READBACK;
+		uint16_t _adcHome=0, _adcGain=1023;     // calibrated level at 0, full scale span of the divider curve
+		uint32_t _verifies=0, _mismatches=0;
 		
 		void _deselectAndSave();
 		void _deselectNoSave();
 		void _stepPot(uint8_t amt,uint8_t dir);
+		uint16_t _readAdc();
+		uint16_t _expected(uint8_t pos);
+		static uint8_t _stepped(uint8_t pos,uint16_t amt,uint8_t dir);
+	};
+
+//
+// Ping-pong output: two X9Cs sharing INC/UD, each with its own CS, behind an analog switch driven from sel
+// (LOW presents A).  Only the pot that is NOT being presented is ever stepped, so the head unit never sees a
+// wiper traverse intermediate resistances, just the switch flipping between two settled values.  That lets the
+// next command be staged while the current one is still being held.  refused() only counts stage() calls the guard
+// turned away, the evidence the live pot is never stepped is the X9C_TRACE check (live_inc, see X9CTrace.h).
+//
+class X9CPair {
+	public:
+		X9CPair(){};
+		~X9CPair(){};
+		void begin(uint8_t csA,uint8_t csB,uint8_t inc,uint8_t ud,uint8_t sel);
+		void setPotMax(bool save=true);         // park both at max and present A
+		void stage(uint8_t pos);                // position the hidden pot, no-op if it's already there
+		void present();                         // flip, the staged pot goes live
+		uint8_t staged() const { return _pos[!_active]; }
+		uint8_t presented() const { return _pos[_active]; }
+		uint32_t flips() const { return _flips; }
+		uint32_t stages() const { return _stages; }
+		uint32_t refused() const { return _refused; }
+	private:
+		X9C      _pot[2];
+		uint8_t  _sel, _active=0;
+		uint8_t  _pos[2]={X9C_UNKNOWN,X9C_UNKNOWN};
+		uint32_t _flips=0, _stages=0, _refused=0;
+
+		void _setHidden(uint8_t which,uint8_t pos);
 	};
 
 #endif // X9C_H
@@ -0,0 +1,79 @@
+#ifndef X9CTRACE_H
+#define X9CTRACE_H
+//
+// Edge capture of the X9C bus (CS/INC/UD, plus the ping-pong select) for timing work.  Build with -DX9C_TRACE.
+//
+// Every pin write X9C makes is stamped with the CPU cycle counter (12.5ns at 80MHz) into a fixed buffer.  When the
+// buffer fills, report() checks the edges against the X9C datasheet minimums and prints the CS-low (bus busy) time of
+// each command marked with mark().  Only when armDump() was called (send X9C_TRACE_DUMP_KEY over serial) does it
+// also dump the capture as a VCD between "$vcd-begin"/"$vcd-end" lines - cut that out of the serial log into a .vcd
+// file and open it in GTKWave.  The dump is about 20KB, tens of seconds at 9600 baud with dispatch stalled, so it's
+// never automatic.
+//
+// With a ping-pong pair (a SEL signal registered) the check also counts INC falling edges while the presented pot's
+// CS is low, live_inc.  Anything but 0 means the head unit saw the wiper move.  The first CS registered is pot A,
+// which SEL low presents.  Stamping adds a few cycles to each write, so measured pulses are a touch longer than the
+// untraced build's.
+//
+#include <Arduino.h>
+
+#ifndef X9C_TRACE_EVENTS
+#define X9C_TRACE_EVENTS    2048            // 8 bytes each, a full setPot + setPotMax is about 800 edges
+#endif
+#define X9C_TRACE_SIGNALS   6
+#define X9C_TRACE_MARK      0xFF            // event pin value for a command marker
+#define X9C_TRACE_MAX_REPORTED 16           // violations printed per capture, the rest are only counted
+#define X9C_TRACE_DUMP_KEY  'v'             // serial byte that arms a VCD dump of the next full capture
+
+// datasheet minimums, ns
+#define X9C_T_CI            100             // CS low to INC low
+#define X9C_T_DI            2900            // U/D to INC low setup
+#define X9C_T_IL            1000            // INC low period
+#define X9C_T_IH            1000            // INC high period
+#define X9C_T_IC            1000            // INC high to CS high
+#define X9C_T_IW            100000          // last INC to deselect, wiper settle (our own requirement, see _stepPot)
+#define X9C_T_CPH           100             // CS deselect time, no store
+#define X9C_T_CPH_STORE     20000000UL      // CS deselect time after a store
+
+enum X9CSignal { X9C_SIG_CS, X9C_SIG_INC, X9C_SIG_UD, X9C_SIG_SEL };
+
+struct X9CTraceEvent {
+	uint32_t  cycles;
+	uint8_t   pin;
+	uint8_t   level;                          // or the command for a X9C_TRACE_MARK
+	};
+
+class X9CTrace {
+	public:
+		X9CTrace(){};
+		~X9CTrace(){};
+		void addSignal(uint8_t pin,uint8_t role);
+		void record(uint8_t pin,uint8_t level){
+			if (_count < X9C_TRACE_EVENTS){
+				_events[_count].cycles=ESP.getCycleCount();
+				_events[_count].pin=pin;
+				_events[_count].level=level;
+				_count++;
+			}
+		}
+		void mark(uint8_t cmd){ record(X9C_TRACE_MARK,cmd); }
+		bool full() const { return _count >= X9C_TRACE_EVENTS; }
+		void report();                          // check + bus busy (+ VCD if armed), then start a new capture
+		void armDump(){ _dumpArmed=true; }
+		void clear(){ _count=0; }
+	private:
+		X9CTraceEvent _events[X9C_TRACE_EVENTS];
+		uint16_t      _count=0;
+		uint8_t       _pins[X9C_TRACE_SIGNALS], _roles[X9C_TRACE_SIGNALS];
+		uint8_t       _signals=0;
+		bool          _dumpArmed=false;
+		int8_t        _presented=-1;            // pot SEL showed at the end of the last capture, -1 not seen yet
+
+		int8_t _signal(uint8_t pin) const;
+		void _check();
+		void _dumpVCD();
+	};
+
+extern X9CTrace x9cTrace;
+
+#endif // X9CTRACE_H
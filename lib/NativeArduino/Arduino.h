@@ -0,0 +1,135 @@
+#ifndef NATIVEARDUINO_H
+#define NATIVEARDUINO_H
+//
+// Host stand-in for the parts of the ESP8266 Arduino core that the modules under src/ use, so [env:native] can build
+// them (everything but main.cpp) and the tests under test/ can drive them.
+//
+// Time is simulated: millis()/micros()/ESP.getCycleCount() only move when a test calls NativeArduino::advance() or
+// the code under test calls delay()/delayMicroseconds(), so waits are instant and runs repeat exactly.  Inputs are
+// set with NativeArduino::setInput(), which fires whatever attachInterrupt()/attachInterruptArg() hooked to the pin
+// like the edge would on the target.  Outputs and the ADC go through optional hooks so a test can model the part on
+// the other end (an X9C, a head unit).  Serial output is kept in Serial.output for tests to search.
+//
+// xt_rsil()/xt_wsr_ps() track the mask level, interrupts from setInput() are still delivered while masked (a test
+// decides where an interrupt lands, see the queue race harness).
+//
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+
+#define LOW             0
+#define HIGH            1
+#define INPUT           0x00
+#define OUTPUT          0x01
+#define INPUT_PULLUP    0x02
+#define RISING          0x01
+#define FALLING         0x02
+#define CHANGE          0x03
+
+// d1_mini pin names, GPIO numbers as on the target
+enum { D0=16, D1=5, D2=4, D3=0, D4=2, D5=14, D6=12, D7=13, D8=15, A0=17 };
+#define NATIVE_PINS     18
+
+typedef bool boolean;
+
+void pinMode(uint8_t pin,uint8_t mode);
+void digitalWrite(uint8_t pin,uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+#define digitalPinToInterrupt(p)  (p)
+void attachInterrupt(uint8_t pin,void (*isr)(),int mode);
+void attachInterruptArg(uint8_t pin,void (*isr)(void *),void *arg,int mode);
+void detachInterrupt(uint8_t pin);
+
+uint32_t xt_rsil(uint32_t level);
+void xt_wsr_ps(uint32_t state);
+
+extern volatile uint32_t GPI;
+#define GPIP(p)   ((GPI >> ((p) & 0x1F)) & 1)
+
+#define TIM_DIV16 1
+#define TIM_EDGE  0
+#define TIM_LOOP  1
+void timer1_isr_init();
+void timer1_attachInterrupt(void (*isr)());
+void timer1_detachInterrupt();
+void timer1_enable(uint8_t divider,uint8_t intType,uint8_t reload);
+void timer1_write(uint32_t ticks);
+void timer1_disable();
+
+#define constrain(amt,low,high) ((amt) < (low) ? (low):((amt) > (high) ? (high):(amt)))
+
+class String : public std::string {
+	public:
+		String(){};
+		String(const char *s):std::string(s ? s:""){};
+		String(const std::string &s):std::string(s){};
+		explicit String(char c):std::string(1,c){};
+		explicit String(signed char v):String((long)v){};
+		explicit String(unsigned char v):String((unsigned long)v){};
+		explicit String(short v):String((long)v){};
+		explicit String(unsigned short v):String((unsigned long)v){};
+		explicit String(int v):String((long)v){};
+		explicit String(unsigned int v):String((unsigned long)v){};
+		explicit String(long v);
+		explicit String(unsigned long v);
+		explicit String(double v);
+		explicit String(bool v):String((unsigned long)v){};
+	};
+
+template <class T> String operator+(const String &a,const T &b){ String r(a); r.append(String(b)); return r; }
+inline String operator+(const char *a,const String &b){ String r(a); r.append(b); return r; }
+
+class HardwareSerial {
+	public:
+		std::string output;                     // everything printed since the last clear()
+		void begin(unsigned long){};
+		template <class T> size_t print(const T &v){ String s(v); output+=s; return s.size(); }
+		template <class T> size_t println(const T &v){ return print(v)+println(); }
+		size_t println(){ output+="\n"; return 1; }
+		int available(){ return _input.size(); }
+		int read(){ int c=_input.empty() ? -1:(uint8_t)_input[0]; if (c >= 0) _input.erase(0,1); return c; }
+		void flush(){};
+		void clear(){ output.clear(); }
+		void feed(const std::string &s){ _input+=s; }   // bytes read() will return
+	private:
+		std::string _input;
+	};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+	public:
+		uint32_t getCycleCount();
+		uint32_t getCpuFreqMHz(){ return 80; }
+		void wdtFeed(){ _wdtFeeds++; }
+		String getResetReason(){ return "native"; }
+		uint32_t wdtFeeds() const { return _wdtFeeds; }
+	private:
+		uint32_t _wdtFeeds=0;
+	};
+
+extern EspClass ESP;
+
+namespace NativeArduino {
+	void reset();                                   // clock to 0, inputs high, hooks and ISRs detached, Serial cleared
+	void advance(uint32_t us);
+	void setInput(uint8_t pin,uint8_t level);       // fires the pin's ISR on a matching edge
+	uint8_t output(uint8_t pin);                    // last digitalWrite() level
+	uint32_t maskLevel();                           // current xt_rsil() level, 0 unmasked
+	extern void (*onWrite)(uint8_t pin,uint8_t level); // called before output() takes the new level
+	extern int  (*onAnalogRead)(uint8_t pin);
+	}
+
+#endif // NATIVEARDUINO_H
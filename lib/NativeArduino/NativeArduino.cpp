@@ -0,0 +1,127 @@
+#include "Arduino.h"
+#include <stdio.h>
+#include <stdarg.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+volatile uint32_t GPI = 0xFFFFFFFF;             // pull-ups, every input idles high
+
+namespace NativeArduino {
+  void (*onWrite)(uint8_t pin,uint8_t level) = NULL;
+  int  (*onAnalogRead)(uint8_t pin) = NULL;
+}
+
+struct NativeIsr {
+  void (*isr)();
+  void (*isrArg)(void *);
+  void  *arg;
+  int    mode;
+};
+
+static uint64_t  NowUs = 0;
+static uint32_t  MaskLevel = 0;
+static uint8_t   Outputs[NATIVE_PINS];
+static NativeIsr Isrs[NATIVE_PINS];
+
+static std::string numberString(const char *format,...){
+  char    buf[32];
+  va_list args;
+
+  va_start(args,format);
+  vsnprintf(buf,sizeof(buf),format,args);
+  va_end(args);
+  return std::string(buf);
+}
+
+String::String(long v):std::string(numberString("%ld",v)){}
+String::String(unsigned long v):std::string(numberString("%lu",v)){}
+String::String(double v):std::string(numberString("%.2f",v)){}
+
+void pinMode(uint8_t,uint8_t){}
+
+void digitalWrite(uint8_t pin,uint8_t val){
+  if (NativeArduino::onWrite)
+    NativeArduino::onWrite(pin,val);    // sees the old level in output(), for edge models
+  if (pin < NATIVE_PINS)
+    Outputs[pin]=val;
+}
+
+int digitalRead(uint8_t pin){ return GPIP(pin); }
+
+int analogRead(uint8_t pin){ return NativeArduino::onAnalogRead ? NativeArduino::onAnalogRead(pin):1023; }
+
+unsigned long millis(){ return (unsigned long)(uint32_t)(NowUs/1000); }
+unsigned long micros(){ return (unsigned long)(uint32_t)NowUs; }
+void delay(unsigned long ms){ NowUs+=(uint64_t)ms*1000; }
+void delayMicroseconds(unsigned int us){ NowUs+=us; }
+void yield(){}
+
+uint32_t EspClass::getCycleCount(){ return (uint32_t)(NowUs*80); }
+
+extern "C" void esp_schedule(){}
+
+void attachInterrupt(uint8_t pin,void (*isr)(),int mode){
+  if (pin < NATIVE_PINS)
+    Isrs[pin]={isr,NULL,NULL,mode};
+}
+
+void attachInterruptArg(uint8_t pin,void (*isr)(void *),void *arg,int mode){
+  if (pin < NATIVE_PINS)
+    Isrs[pin]={NULL,isr,arg,mode};
+}
+
+void detachInterrupt(uint8_t pin){
+  if (pin < NATIVE_PINS)
+    Isrs[pin]=NativeIsr();
+}
+
+uint32_t xt_rsil(uint32_t level){
+  uint32_t saved=MaskLevel;
+
+  MaskLevel=level;
+  return saved;
+}
+
+void xt_wsr_ps(uint32_t state){ MaskLevel=state; }
+
+void timer1_isr_init(){}
+void timer1_attachInterrupt(void (*)()){}
+void timer1_detachInterrupt(){}
+void timer1_enable(uint8_t,uint8_t,uint8_t){}
+void timer1_write(uint32_t){}
+void timer1_disable(){}
+
+void NativeArduino::reset(){
+  NowUs=0;
+  MaskLevel=0;
+  GPI=0xFFFFFFFF;
+  memset(Outputs,0,sizeof(Outputs));
+  memset(Isrs,0,sizeof(Isrs));
+  onWrite=NULL;
+  onAnalogRead=NULL;
+  Serial.clear();
+}
+
+void NativeArduino::advance(uint32_t us){ NowUs+=us; }
+
+void NativeArduino::setInput(uint8_t pin,uint8_t level){
+  uint8_t    was=GPIP(pin);
+  NativeIsr &h=Isrs[pin % NATIVE_PINS];
+
+  if (level)
+    GPI|=1UL << pin;
+  else
+    GPI&=~(1UL << pin);
+  if (was == level || pin >= NATIVE_PINS)
+    return;
+  if (h.mode == CHANGE || (h.mode == RISING && level) || (h.mode == FALLING && !level)){
+    if (h.isr)
+      h.isr();
+    else if (h.isrArg)
+      h.isrArg(h.arg);
+  }
+}
+
+uint8_t NativeArduino::output(uint8_t pin){ return pin < NATIVE_PINS ? Outputs[pin]:LOW; }
+
+uint32_t NativeArduino::maskLevel(){ return MaskLevel; }
@@ -0,0 +1,31 @@
+#
+# PlatformIO post build step: prints the RAM sections of the firmware so queue / buffer sizing changes
+# can be compared build to build (QUEUEMAXSIZE etc).  Hooked up from platformio.ini extra_scripts.
+#
+import subprocess
+
+Import("env")
+
+RAM_SECTIONS = (".data", ".rodata", ".bss")
+
+
+def memory_report(source, target, env):
+    elf = str(target[0])
+    size_tool = env.subst("$SIZETOOL") or "xtensa-lx106-elf-size"
+    try:
+        output = subprocess.check_output([size_tool, "-A", "-d", elf]).decode()
+    except (OSError, subprocess.CalledProcessError) as err:
+        print("memory_report: could not run %s (%s)" % (size_tool, err))
+        return
+
+    total = 0
+    print("RAM sections for %s" % elf)
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0] in RAM_SECTIONS:
+            total += int(fields[1])
+            print("  %-8s %7s bytes" % (fields[0], fields[1]))
+    print("  %-8s %7d bytes" % ("total", total))
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", memory_report)
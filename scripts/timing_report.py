@@ -0,0 +1,56 @@
+#
+# PlatformIO pre build step: compiles include/TimingModel.h with the host compiler and prints the worst case
+# command / full queue timing for this environment's build flags.  The target build enforces the same numbers with
+# static_asserts, this just makes them visible.  Hooked up from platformio.ini extra_scripts.
+#
+import os
+import subprocess
+import tempfile
+
+Import("env")
+
+REPORT_SOURCE = r"""
+#include <stdio.h>
+#include "TimingModel.h"
+int main()
+{
+  printf("Timing model (QUEUEMAXSIZE=%d)\n", QUEUEMAXSIZE);
+  printf("  press (max rest)   %8lu us\n", (unsigned long)TimingModel::pressUs(TimingModel::largestRest()));
+  printf("  release            %8lu us\n", (unsigned long)TimingModel::releaseUs());
+  printf("  worst command      %8lu us  budget %lu ms\n", (unsigned long)TimingModel::worstCommandUs(),
+         (unsigned long)LATENCY_BUDGET_COMMAND_MS);
+  printf("  bounded response   %8lu us  (longest TTL + worst command)\n", (unsigned long)TimingModel::boundedResponseUs());
+  printf("  stall expires      %8lu us  (loop() pass, queued commands dropped)\n", (unsigned long)TimingModel::stallExpireUs());
+  printf("  full queue drain   %8lu us  budget %lu ms\n", (unsigned long)TimingModel::fullQueueUs(QUEUEMAXSIZE),
+         (unsigned long)LATENCY_BUDGET_QUEUE_MS);
+  return 0;
+}
+"""
+
+
+# a pre: script runs before PlatformIO moves build_flags into CPPDEFINES, so take the -D flags from BUILD_FLAGS
+def build_defines():
+    flags = []
+    for define in env.ParseFlags(env.get("BUILD_FLAGS", [])).get("CPPDEFINES", []):
+        if isinstance(define, (list, tuple)):
+            flags.append("-D%s=%s" % (define[0], env.subst(str(define[1]))))
+        else:
+            flags.append("-D%s" % define)
+    return flags
+
+
+def timing_report():
+    include_dir = os.path.join(env.subst("$PROJECT_DIR"), "include")
+    with tempfile.TemporaryDirectory() as workdir:
+        source = os.path.join(workdir, "timing_report.cpp")
+        binary = os.path.join(workdir, "timing_report")
+        with open(source, "w") as f:
+            f.write(REPORT_SOURCE)
+        try:
+            subprocess.check_call(["c++", "-std=c++11", "-I", include_dir] + build_defines() + [source, "-o", binary])
+            print(subprocess.check_output([binary]).decode())
+        except (OSError, subprocess.CalledProcessError) as err:
+            print("timing_report: no host report (%s), the static_asserts still apply to the target build" % err)
+
+
+timing_report()
@@ -0,0 +1,106 @@
+#include "ButtonLadder.h"
+
+void ButtonLadder::begin(uint8_t pin,const LadderButton *table,uint8_t count){
+  _pin=pin;
+  _table=table;
+  _count=(count < INPUT_LADDER_BUTTONS) ? count:INPUT_LADDER_BUTTONS;
+  _candidate=-1;
+  _pressed=-1;
+  _stable=0;
+}
+
+int8_t ButtonLadder::_classify(uint16_t level){
+  uint8_t i;
+
+  for (i=0;i<_count;i++)
+    if (level >= _table[i].low && level <= _table[i].high)
+      return i;
+  return -1;
+}
+
+bool ButtonLadder::sample(InputEvent &event){
+  uint16_t sum=0;
+  uint8_t  i;
+  int8_t   button, debounced, index=-1;
+  uint32_t now;
+
+  for (i=0;i<LADDER_OVERSAMPLE;i++)
+    sum+=analogRead(_pin);
+  _level=sum/LADDER_OVERSAMPLE;
+
+  button=_classify(_level);
+  if (button != _candidate){
+    _candidate=button;
+    _candidateUs=micros();            // the edge we'll measure latency from
+    _stable=1;
+  }
+  else if (_stable < LADDER_DEBOUNCE_SAMPLES)
+    _stable++;
+
+  debounced=(_stable >= LADDER_DEBOUNCE_SAMPLES) ? _candidate:_pressed;
+  now=millis();
+  _eventUs=0;
+
+  if (debounced != _pressed){
+    if (_pressed >= 0 && _table[_pressed].holdCommand && !_holdSent){
+      index=_pressed;                 // short press, released before the hold time
+      event.type=INPUT_PRESS;
+      _eventUs=_candidateUs;
+    }
+    if (debounced >= 0){
+      _pressMillis=now;
+      _holdSent=false;
+      if (!_table[debounced].holdCommand){
+        index=debounced;
+        event.type=INPUT_PRESS;
+        _eventUs=_candidateUs;
+        _repeatMillis=now+LADDER_HOLD_MS;
+      }
+    }
+    _pressed=debounced;
+  }
+  else if (_pressed >= 0){
+    if (_table[_pressed].holdCommand){
+      if (!_holdSent && now-_pressMillis >= LADDER_HOLD_MS){
+        index=_pressed;
+        event.type=INPUT_LONG_PRESS;
+        _holdSent=true;
+      }
+    }
+    else if ((_table[_pressed].flags & LADDER_REPEAT) && (int32_t)(now-_repeatMillis) >= 0){
+      index=_pressed;
+      event.type=INPUT_PRESS;
+      _repeatMillis=now+LADDER_REPEAT_MS;
+    }
+  }
+
+  if (index < 0)
+    return false;
+  event.source=INPUT_LADDER;
+  event.index=index;
+  event.magnitude=1;
+  event.timestamp=now;
+  return true;
+}
+
+void ButtonLadder::noteEnqueued(){
+  uint32_t latency;
+
+  if (!_eventUs)
+    return;                           // hold / repeat, nothing to measure against
+  latency=micros()-_eventUs;
+  _events++;
+  _lastLatencyUs=latency;
+  if (latency > _maxLatencyUs)
+    _maxLatencyUs=latency;
+}
+
+void ButtonLadder::report(){
+  Serial.println((String)"Ladder level="+_level+" events="+_events+" press_to_queue_us last="+_lastLatencyUs+" max="+_maxLatencyUs);
+}
+
+void ButtonLadder::resetStats(){
+  _events=0;
+  _lastLatencyUs=0;
+  _maxLatencyUs=0;
+}
@@ -0,0 +1,51 @@
+#include "IdleGovernor.h"
+
+extern "C" void esp_schedule();
+
+void IdleGovernor::sleep(uint16_t ms){
+  uint32_t start, expected, resumed, latency;
+
+  _wakeRequestUs=0;
+  _sleeping=true;
+  start=micros();
+  delay(ms);                          // esp_schedule() from wake() returns from here early
+  _sleeping=false;
+  resumed=micros();
+
+  if (_wakeRequestUs){
+    expected=_wakeRequestUs;
+    _earlyWakes++;
+  }
+  else
+    expected=start+ms*1000UL;
+  latency=(int32_t)(resumed-expected) > 0 ? resumed-expected:0;
+
+  _sleeps++;
+  _sleptUs+=resumed-start;
+  _lastLatencyUs=latency;
+  if (latency > _maxLatencyUs)
+    _maxLatencyUs=latency;
+}
+
+void ICACHE_RAM_ATTR IdleGovernor::wake(){
+  if (_sleeping && !_wakeRequestUs){
+    _wakeRequestUs=micros();
+    esp_schedule();
+  }
+}
+
+void IdleGovernor::report(){
+  uint32_t window=micros()-_statsStartUs;
+
+  Serial.println((String)"Idle sleeps="+_sleeps+" early="+_earlyWakes+" idle%="+(window ? (uint32_t)((uint64_t)_sleptUs*100/window):0)+
+                 " wake_us last="+_lastLatencyUs+" max="+_maxLatencyUs);
+}
+
+void IdleGovernor::resetStats(){
+  _sleeps=0;
+  _earlyWakes=0;
+  _lastLatencyUs=0;
+  _maxLatencyUs=0;
+  _sleptUs=0;
+  _statsStartUs=micros();
+}
@@ -0,0 +1,18 @@
+#include "InputRouter.h"
+
+uint8_t InputRouter::route(const InputEvent &e){
+  uint8_t cmd, n, row=_row(e.source,e.index);
+
+  if (row >= INPUT_ROWS || e.type >= INPUT_EVENT_TYPES || !_sink)
+    return 0;
+  cmd=_table[row][e.type];
+  if (!cmd){
+    _unbound++;
+    return 0;
+  }
+
+  for (n=e.magnitude;n;n--)
+    _sink(cmd);
+  _routed++;
+  return cmd;
+}
@@ -0,0 +1,63 @@
+#include "LoopMonitor.h"
+
+void LoopMonitor::beginLoop(){
+  _loopStart=micros();
+}
+
+void LoopMonitor::endLoop(){
+  uint32_t us=micros()-_loopStart;
+  uint8_t bucket=0;
+
+  while (us >> bucket && bucket < LOOP_HISTOGRAM_BUCKETS-1)
+    bucket++;
+  _histogram[bucket]++;
+  if (us > _maxLoopUs)
+    _maxLoopUs=us;
+
+  ESP.wdtFeed();                      // every thread and section came back, the loop is alive
+}
+
+void LoopMonitor::beginThread(struct pt *pt){
+  _threadFrom=pt ? pt->lc:0;
+  _threadStart=micros();
+}
+
+void LoopMonitor::endThread(uint8_t thread,struct pt *pt){
+  uint32_t us=micros()-_threadStart;
+  LoopStall *stall;
+
+  if (us < LOOP_STALL_US)
+    return;
+
+  stall=&_stallLog[_stalls % LOOP_STALL_LOG];
+  stall->at=millis()-us/1000;
+  stall->duration=us;
+  stall->thread=thread;
+  stall->fromLine=_threadFrom;
+  stall->toLine=pt ? pt->lc:0;
+  _stalls++;
+}
+
+void LoopMonitor::report(){
+  uint8_t  i;
+  uint32_t n=_stalls < LOOP_STALL_LOG ? _stalls:LOOP_STALL_LOG;
+  String   line="Loop max_us="+String(_maxLoopUs)+" stalls="+String(_stalls)+" hist";
+
+  for (i=0;i<LOOP_HISTOGRAM_BUCKETS;i++)
+    line+=" "+String(_histogram[i]);
+  Serial.println(line);
+
+  for (i=0;i<n;i++){
+    LoopStall &s=_stallLog[(_stalls-n+i) % LOOP_STALL_LOG];
+    if (s.thread >= LOOP_SECTION_TRACE)
+      Serial.println((String)"  stall at="+s.at+" us="+s.duration+" section "+(s.thread == LOOP_SECTION_TRACE ? "trace":"report"));
+    else
+      Serial.println((String)"  stall at="+s.at+" us="+s.duration+" pt"+s.thread+" line "+s.fromLine+"->"+s.toLine);
+  }
+}
+
+void LoopMonitor::resetStats(){
+  memset(_histogram,0,sizeof(_histogram));
+  _maxLoopUs=0;
+  _stalls=0;
+}
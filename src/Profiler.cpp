@@ -0,0 +1,38 @@
+#include "Profiler.h"
+
+#ifdef PROFILE_ENABLED
+
+Profiler profiler;
+
+static const char *ProfileTaskNames[PROFILE_TASKS] = { "encoder", "dispatch", "x9c", "serial", "ladder" };
+
+static void printSlot(const String &name,const ProfileSlot &live){
+  uint32_t mhz=ESP.getCpuFreqMHz();
+  uint32_t savedPS=xt_rsil(15);
+  ProfileSlot slot=live;              // consistent copy, an ISR can add to it mid print
+  xt_wsr_ps(savedPS);
+
+  Serial.println("  "+name+" calls="+String(slot.calls)+" us="+String((uint32_t)(slot.cycles/mhz))+
+                 " avg_cyc="+String(slot.calls ? (uint32_t)(slot.cycles/slot.calls):0)+" max_cyc="+String(slot.maxCycles));
+}
+
+void Profiler::report(){
+  uint8_t i;
+
+  Serial.println((String)"Profile window_ms="+(millis()-_startMillis));
+  for (i=0;i<PROFILE_TASKS;i++)
+    printSlot(ProfileTaskNames[i],_tasks[i]);
+  for (i=0;i<PROFILE_COMMANDS;i++)
+    if (_commands[i].calls)
+      printSlot("cmd"+String(i),_commands[i]);
+}
+
+void Profiler::resetStats(){
+  uint32_t savedPS=xt_rsil(15);
+  memset(_tasks,0,sizeof(_tasks));
+  memset(_commands,0,sizeof(_commands));
+  xt_wsr_ps(savedPS);
+  _startMillis=millis();
+}
+
+#endif // PROFILE_ENABLED
@@ -0,0 +1,67 @@
+#include "PushButton.h"
+
+void PushButton::begin(uint8_t pin,InputRouter *router,uint8_t source,uint16_t debounceMs,void (*onRelease)()){
+  _pin=pin;
+  _router=router;
+  _source=source;
+  _debounceMs=debounceMs;
+  _onRelease=onRelease;
+
+  pinMode(_pin,INPUT_PULLUP);
+  _down=(digitalRead(_pin) == LOW);
+  _released=false;
+  _edgeMillis=millis();
+
+  attachInterruptArg(digitalPinToInterrupt(_pin),_isr,this,CHANGE);
+}
+
+void ICACHE_RAM_ATTR PushButton::_isr(void *arg){
+  ((PushButton *)arg)->_edge();
+}
+
+void ICACHE_RAM_ATTR PushButton::_set(bool down,unsigned long now){
+  _edgeMillis=now;
+  _down=down;
+  if (down)
+    _downMillis=now;
+  else {
+    _heldMillis=now-_downMillis;
+    _released=true;
+  }
+}
+
+void ICACHE_RAM_ATTR PushButton::_edge(){
+  unsigned long now=millis();
+  bool          down=(digitalRead(_pin) == LOW);
+
+  if (down == _down || now-_edgeMillis < _debounceMs)
+    return;
+  _set(down,now);
+  if (!down && _onRelease)
+    _onRelease();
+}
+
+void PushButton::service(){
+  InputEvent    event;
+  unsigned long now, held=0;
+  bool          released;
+  uint32_t      savedPS=xt_rsil(15);
+
+  now=millis();
+  if (now-_edgeMillis >= _debounceMs && (digitalRead(_pin) == LOW) != _down)
+    _set(!_down,now);
+  released=_released;
+  if (released)
+    held=_heldMillis;
+  _released=false;
+  xt_wsr_ps(savedPS);
+
+  if (!released || !_router)
+    return;
+  event.source=_source;
+  event.type=(held >= INPUT_LONG_PRESS_MS) ? INPUT_LONG_PRESS:INPUT_PRESS;
+  event.index=0;
+  event.magnitude=1;
+  event.timestamp=now;
+  _router->route(event);
+}
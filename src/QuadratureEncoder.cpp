@@ -0,0 +1,141 @@
+#include "QuadratureEncoder.h"
+
+// index is (previous state << 2) | current state, state is (A << 1) | B
+static const int8_t QuadTable[16] = {
+   0, -1,  1,  0,
+   1,  0,  0, -1,
+  -1,  0,  0,  1,
+   0,  1, -1,  0
+};
+
+void QuadratureEncoder::begin(uint8_t pinA,uint8_t pinB,uint16_t minEdgeUs,void (*onDetent)()){
+  _pinA=pinA;
+  _pinB=pinB;
+  _minEdgeCycles=(uint32_t)minEdgeUs*ESP.getCpuFreqMHz();
+  _onDetent=onDetent;
+
+  pinMode(_pinA,INPUT_PULLUP);
+  pinMode(_pinB,INPUT_PULLUP);
+  _state=(GPIP(_pinA) << 1) | GPIP(_pinB);
+  _lastEdge=ESP.getCycleCount();
+
+  attachInterruptArg(digitalPinToInterrupt(_pinA),_isr,this,CHANGE);
+  attachInterruptArg(digitalPinToInterrupt(_pinB),_isr,this,CHANGE);
+}
+
+void ICACHE_RAM_ATTR QuadratureEncoder::_isr(void *arg){
+  ((QuadratureEncoder *)arg)->_edge();
+}
+
+#ifdef QUAD_REFERENCE_DECODER
+// the Encoder library's update(): the switch replaces the table and a skipped step counts double instead of invalid
+void ICACHE_RAM_ATTR QuadratureEncoder::_edge(){
+  uint32_t start=ESP.getCycleCount();
+  uint8_t  state=_state & 3;
+  uint32_t cycles;
+
+  if (GPIP(_pinB)) state|=4;        // the library's pin1 was dtPin, our B
+  if (GPIP(_pinA)) state|=8;
+  _state=state >> 2;
+  switch(state){
+    case 1: case 7: case 8: case 14:
+      _position++;
+      break;
+    case 2: case 4: case 11: case 13:
+      _position--;
+      break;
+    case 3: case 12:
+      _position+=2;
+      break;
+    case 6: case 9:
+      _position-=2;
+      break;
+  }
+  if (_position/QUAD_STEPS_PER_COUNT != _detents){
+    _detents=_position/QUAD_STEPS_PER_COUNT;
+    if (_onDetent)
+      _onDetent();
+  }
+
+  cycles=ESP.getCycleCount()-start;
+  _isrCalls++;
+  _isrCycles+=cycles;
+  if (cycles > _isrMaxCycles)
+    _isrMaxCycles=cycles;
+}
+#else
+// every edge is decoded, so _state never drifts from the pins and a bounce straight back takes its step back through
+// the table.  The window applies to the rest level: a detent is only pending when the rest is reached and stands
+// once the rest has been quiet for minEdgeUs, checked by the next edge or by read().  An edge inside the window
+// (a glitch) cancels it.
+void ICACHE_RAM_ATTR QuadratureEncoder::_edge(){
+  uint32_t start=ESP.getCycleCount();
+  uint8_t  state=(GPIP(_pinA) << 1) | GPIP(_pinB);
+  bool     quiet=start-_lastEdge >= _minEdgeCycles;
+  int8_t   delta;
+  uint32_t cycles;
+
+  _lastEdge=start;                    // every raw edge, rejected or not, restarts the window
+  if (!quiet)
+    _glitches++;
+  if (_pending){
+    if (quiet)
+      _commit();                      // the rest held for the window
+    else
+      _pending=0;                     // bounced off the rest, the step comes back out below
+  }
+
+  if (state != _state){
+    _edges++;
+    delta=QuadTable[(_state << 2) | state];
+    if (!delta)
+      _invalid++;                     // both pins changed, a step was missed
+    _steps+=delta;
+    _state=state;
+  }
+
+  if (state == QUAD_REST || (QUAD_STEPS_PER_COUNT == 2 && state == QUAD_REST_HALF)){
+    if (_steps >= QUAD_STEPS_PER_COUNT / 2 || _steps <= -QUAD_STEPS_PER_COUNT / 2){
+      if (!_pending && _onDetent)
+        _onDetent();                  // get loop() round to read() it
+      _pending=(_steps > 0) ? 1:-1;
+    }
+    else
+      _steps=0;
+  }
+
+  cycles=ESP.getCycleCount()-start;
+  _isrCalls++;
+  _isrCycles+=cycles;
+  if (cycles > _isrMaxCycles)
+    _isrMaxCycles=cycles;
+}
+#endif
+
+long QuadratureEncoder::read(){
+#ifndef QUAD_REFERENCE_DECODER
+  uint32_t savedPS;
+
+  if (_pending){
+    savedPS=xt_rsil(15);
+    if (_pending && ESP.getCycleCount()-_lastEdge >= _minEdgeCycles)
+      _commit();                      // no edge since it reached the rest, it has settled
+    xt_wsr_ps(savedPS);
+  }
+#endif
+  return _detents;
+}
+
+void QuadratureEncoder::report(){
+  Serial.println((String)"Encoder detents="+_detents+" edges="+_edges+" glitches="+_glitches+" invalid="+_invalid+
+                 " isr_calls="+_isrCalls+" isr_cyc avg="+(_isrCalls ? _isrCycles/_isrCalls:0)+" max="+_isrMaxCycles);
+}
+
+void QuadratureEncoder::resetStats(){
+  _edges=0;
+  _glitches=0;
+  _invalid=0;
+  _isrCalls=0;
+  _isrCycles=0;
+  _isrMaxCycles=0;
+}
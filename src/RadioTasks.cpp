@@ -0,0 +1,284 @@
+#include "RadioTasks.h"
+#include "X9CTrace.h"
+#include "Profiler.h"
+
+static constexpr int LadderSampleDelay            = 5;          // ms between ladder samples, each sample is a fixed LADDER_OVERSAMPLE reads
+
+RadioQueue Queue;
+
+#ifdef QUEUE_STRESS
+void (*volatile QueueStressHook)() = NULL;                    // set by the race harness, see CommandQueue.h
+#endif
+
+//  commands
+void PulseVolumeUp()
+{
+  Queue.push(VOLUMEUP);
+  PROFILE_RUN(PROFILE_SERIAL, Serial.println("PULSE-UP"));
+}
+void PulseVolumeDown()
+{
+  Queue.push(VOLUMEDOWN);
+  PROFILE_RUN(PROFILE_SERIAL, Serial.println("PULSE-DOWN"));
+}
+void PulseTrackForward(void)
+{
+  Queue.push(TRACKFF);
+  PROFILE_RUN(PROFILE_SERIAL, Serial.println("PULSE-FF"));
+}
+void PulseTrackBack(void)
+{
+  Queue.push(TRACKPV);
+  PROFILE_RUN(PROFILE_SERIAL, Serial.println("PULSE-PV"));
+}
+void PulseMute(void)
+{
+  Queue.push(MUTE);
+  PROFILE_RUN(PROFILE_SERIAL, Serial.println("PULSE-MUTE"));
+}
+void PulseTripleClick(void)
+{
+  Queue.push(TRIPLECLICK);
+  PROFILE_RUN(PROFILE_SERIAL, Serial.println("PULSE-TRIPLE"));
+}
+
+void PulseCommand(uint8_t cmd)
+{
+  switch(cmd)
+  {
+    case VOLUMEUP:    PulseVolumeUp();     break;
+    case VOLUMEDOWN:  PulseVolumeDown();   break;
+    case TRACKFF:     PulseTrackForward(); break;
+    case TRACKPV:     PulseTrackBack();    break;
+    case MUTE:        PulseMute();         break;
+    case TRIPLECLICK: PulseTripleClick();  break;
+  }
+}
+
+// resistance the head unit has to see for a queued command, 0 for anything it has no button for
+uint8_t CommandRest(uint8_t cmd)
+{
+  switch(cmd)
+  {
+    case VOLUMEUP:    return REST_VOLUMEUP;
+    case VOLUMEDOWN:  return REST_VOLUMEDOWN;
+    case TRACKFF:     return REST_TRACKFF;
+    case TRACKPV:     return REST_TRACKPV;
+    case MUTE:        return REST_MUTE;
+  }
+  return 0;
+}
+
+
+void EncoderTaskInit(struct EncoderTask *t, QuadratureEncoder *encoder, InputRouter *router, uint8_t source)
+{
+  *t = EncoderTask();
+  t->encoder = encoder;
+  t->router = router;
+  t->source = source;                                         // counts from 0, so detents turned while booting are still played
+  PT_INIT(&t->pt);
+}
+
+int protothread1(struct EncoderTask *t)
+{
+  InputEvent event;
+
+  PT_BEGIN(&t->pt);
+
+  while(1)
+  {
+    t->counter = t->encoder->read();
+
+    if (t->counter != t->lastVolumeCount)                       // debounced counts (QUAD_STEPS_PER_COUNT), all of them get queued
+    {
+      event.source = t->source;
+      event.type = (t->counter > t->lastVolumeCount) ? INPUT_STEP_UP : INPUT_STEP_DOWN;
+      event.index = 0;
+      event.magnitude = constrain(labs(t->counter - t->lastVolumeCount), 1, 255);
+      event.timestamp = millis();
+      t->router->route(event);
+      t->lastVolumeCount = t->counter;
+    }
+
+    t->timestamp = millis(); PT_WAIT_UNTIL(&t->pt, millis() - t->timestamp > MinSliceDelay);                        // allow other thread some time
+  }
+
+  PT_END(&t->pt);
+}
+
+
+void DispatchTaskInit(struct DispatchTask *t, RadioQueue *queue, OutputPot *pot)
+{
+  *t = DispatchTask();
+  t->queue = queue;
+  t->pot = pot;
+  PT_INIT(&t->pt);
+}
+
+int protothread2(struct DispatchTask *t)
+{
+  PT_BEGIN(&t->pt);
+
+  while(1)
+  {
+    t->Command=0;
+    t->CurLimit=t->queue->count();                              // only work the commands that are queued now, newer ones wait for the next pass
+
+    if (t->CurLimit != 0)
+    {
+      t->Busy=true;
+      PROFILE_RUN(PROFILE_SERIAL, Serial.println((String)"QueueCount="+t->CurLimit+" Dropped="+t->queue->dropped()));
+      for (t->LoopOfThread = 0; t->LoopOfThread < t->CurLimit; t->LoopOfThread++)
+      {
+          t->TempCommand = t->queue->pop(&t->Age);
+          if (t->TempCommand < COMMAND_CODES && CommandTTL[t->TempCommand] && t->Age > CommandTTL[t->TempCommand])
+          {
+            t->Expired[t->TempCommand]++;                       // stale, playing it now would only overshoot
+            continue;
+          }
+          t->Command=0;
+          switch(t->TempCommand)
+          {
+            case VOLUMEUP:
+              t->Command = REST_VOLUMEUP;
+              PROFILE_RUN(PROFILE_SERIAL, Serial.print("UP "));
+              break;
+            case VOLUMEDOWN:
+              t->Command = REST_VOLUMEDOWN;
+              PROFILE_RUN(PROFILE_SERIAL, Serial.print("DOWN "));
+              break;
+            case TRACKFF:
+              t->Command = REST_TRACKFF;
+              PROFILE_RUN(PROFILE_SERIAL, Serial.print("FF "));
+              break;
+            case TRACKPV:
+              t->Command = REST_TRACKPV;
+              PROFILE_RUN(PROFILE_SERIAL, Serial.print("PV "));
+              break;
+            case MUTE:
+              t->Command = REST_MUTE;
+              PROFILE_RUN(PROFILE_SERIAL, Serial.print("MUTE "));
+              break;
+            case 0:
+              PROFILE_RUN(PROFILE_SERIAL, Serial.println("I hit 0"));
+              t->Command = 0;
+              break;
+            default:
+              PROFILE_RUN(PROFILE_SERIAL, Serial.println((String)"Dont think I should hit these Command="+t->TempCommand+" LoopOfThread="+t->LoopOfThread+ " CurLimit="+t->CurLimit));
+              t->Command=0;
+              t->timestamp = millis(); PT_WAIT_UNTIL(&t->pt, millis() - t->timestamp > DeBounceDelay);
+              break;
+          }
+
+          if (t->Command != 0)
+          {
+              t->timestamp = millis();
+              if (t->timestamp-t->PreviousCommandTimeStamp > WaitTimeForBetweenScreens && !t->InsideAQueueProcess && t->TempCommand < SCREENRANGE)    // SCREENRANGE must be +1 then ALL display impacting cases
+              {
+                t->PreviousCommandTimeStamp = t->timestamp;
+                t->WaitForDisplay=true;
+              }
+
+              t->InsideAQueueProcess=true;
+              t->TimeWhenInQueue = millis();
+
+#ifdef X9C_TRACE
+              x9cTrace.mark(t->TempCommand);
+#endif
+
+#ifdef X9C_PINGPONG
+              PROFILE_COMMAND(t->TempCommand, t->pot->stage(t->Command));                                                            // normally already staged during the previous release
+              t->pot->present();
+#elif defined(X9C_READBACK)
+              PROFILE_COMMAND(t->TempCommand, t->pot->moveTo(t->Command,false));                                                     // verified before it's held
+#else
+              PROFILE_COMMAND(t->TempCommand, t->pot->setPot(t->Command,false));
+#endif
+              t->timestamp = millis(); PT_WAIT_UNTIL(&t->pt, millis() - t->timestamp > WaitForUnitToComplete);                       // allow stereo time to handle the input
+              PROFILE_RUN(PROFILE_SERIAL, Serial.println("CommandDone"));
+
+#ifdef X9C_PINGPONG
+              t->pot->present();                                                                                               // back to the pot parked at max
+              if (CommandRest(t->queue->peek()) != 0)
+                PROFILE_COMMAND(t->queue->peek(), t->pot->stage(CommandRest(t->queue->peek())));                                       // hidden pot takes the next command while the unit settles
+#elif defined(X9C_READBACK)
+              PROFILE_COMMAND(t->TempCommand, t->pot->moveTo(X9C_MAX,false));                                                        // NVRAM already holds max (HomePot)
+#else
+              PROFILE_COMMAND(t->TempCommand, t->pot->setPotMax(true));
+#endif
+              t->timestamp = millis(); PT_WAIT_UNTIL(&t->pt, millis() - t->timestamp > WaitForUnitToComplete);                       // allow stereo time to handle the input
+
+              if (t->WaitForDisplay)
+              {
+                  PROFILE_RUN(PROFILE_SERIAL, Serial.println("Waiting for Screen"));
+                  t->WaitForDisplay = false;
+                  t->timestamp = millis(); PT_WAIT_UNTIL(&t->pt, millis() - t->timestamp > WaitForDisplayTime);                // allow stereo time to handle the input
+                  PROFILE_RUN(PROFILE_SERIAL, Serial.println("Screen should be up, do any other commands"));
+              }
+          }
+          t->Command=0;
+      } // when the for-next loop is done (all the commands on the queue)
+      t->Busy=false;
+    }
+    else // if you are here there was no messages in the queue
+    {
+      t->timestamp = millis();
+      if (t->timestamp-t->TimeWhenInQueue > WaitTimeForBetweenScreens)
+      {
+          if (t->InsideAQueueProcess)
+            PROFILE_RUN(PROFILE_SERIAL, Serial.println("The screen is no longer on "));
+          t->InsideAQueueProcess=false;
+      }
+    }
+    t->timestamp = millis(); PT_WAIT_UNTIL(&t->pt, millis() - t->timestamp > MinSliceDelay);                                // allow other thread some time
+  }
+  PT_END(&t->pt);
+}
+
+
+// after a stall the queue's 8 bit stamps can't be trusted, count everything queued as expired.  A batch that's running
+// ends after the command in flight, the rest of its CurLimit went with the queue
+uint16_t DispatchTaskExpire(struct DispatchTask *t)
+{
+  uint16_t expired = 0;
+  uint8_t cmd;
+
+  while ((cmd = t->queue->pop()) != COMMANDQUEUE_EMPTY)
+  {
+    if (cmd < COMMAND_CODES)
+      t->Expired[cmd]++;
+    expired++;
+  }
+  if (t->Busy && t->CurLimit > t->LoopOfThread + 1)
+    t->CurLimit = t->LoopOfThread + 1;
+  return expired;
+}
+
+
+void LadderTaskInit(struct LadderTask *t, ButtonLadder *ladder, InputRouter *router)
+{
+  *t = LadderTask();
+  t->ladder = ladder;
+  t->router = router;
+  PT_INIT(&t->pt);
+}
+
+int protothread3(struct LadderTask *t)
+{
+  InputEvent event;
+
+  PT_BEGIN(&t->pt);
+
+  while(1)
+  {
+    if (t->ladder->sample(event))
+    {
+      t->router->route(event);
+      t->ladder->noteEnqueued();
+    }
+
+    t->timestamp = millis(); PT_WAIT_UNTIL(&t->pt, millis() - t->timestamp > LadderSampleDelay);                    // allow other threads some time
+  }
+
+  PT_END(&t->pt);
+}
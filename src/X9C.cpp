@@ -20,24 +20,32 @@ SOFTWARE.
 
 #include "X9C.h"
 
+#ifdef X9C_TRACE
+#include "X9CTrace.h"
+#define X9C_WRITE(pin,val)  do { digitalWrite(pin,val); x9cTrace.record(pin,val); } while(0)
+#else
+#define X9C_WRITE(pin,val)  digitalWrite(pin,val)
+#endif
+
 void X9C::_deselectAndSave(){
-  digitalWrite(_cs,HIGH);             // unselect chip and write current value to NVRAM
+  X9C_WRITE(_cs,HIGH);                // unselect chip and write current value to NVRAM
 }
 
 void X9C::_deselectNoSave(){
-  digitalWrite(_inc,LOW);  
-  digitalWrite(_cs,HIGH);             // unselect chip
-  digitalWrite(_inc,HIGH);            // always leave inc high - makes coding cleaner / easier
+  X9C_WRITE(_inc,LOW);  
+  X9C_WRITE(_cs,HIGH);                // unselect chip
+  X9C_WRITE(_inc,HIGH);               // always leave inc high - makes coding cleaner / easier
 }
 
 void X9C::_stepPot(uint8_t amt,uint8_t dir){
   uint8_t cnt=(amt > X9C_MAX) ? X9C_MAX:amt;
-  digitalWrite(_ud,dir);              // set direction
-  digitalWrite(_cs,LOW);              // select chip
+  X9C_WRITE(_ud,dir);                 // set direction
+  delayMicroseconds(X9C_TDI_US);      // U/D has to settle before the first INC fall (tDI)
+  X9C_WRITE(_cs,LOW);                 // select chip
   while(cnt--){
-    digitalWrite(_inc,LOW);           // falling pulse triggers wiper change (xN = cnt)
+    X9C_WRITE(_inc,LOW);              // falling pulse triggers wiper change (xN = cnt)
     delayMicroseconds(1);       
-    digitalWrite(_inc,HIGH);
+    X9C_WRITE(_inc,HIGH);
     delayMicroseconds(1);
   }
   delayMicroseconds(100);             // let new value settle; (datasheet P7 tIW)
@@ -51,26 +59,170 @@ void X9C::begin(uint8_t cs,uint8_t inc,uint8_t ud){
     pinMode(_cs,OUTPUT);
     pinMode(_inc,OUTPUT);
     pinMode(_ud,OUTPUT);
+#ifdef X9C_TRACE
+    x9cTrace.addSignal(_cs,X9C_SIG_CS);
+    x9cTrace.addSignal(_inc,X9C_SIG_INC);
+    x9cTrace.addSignal(_ud,X9C_SIG_UD);
+#endif
+}
+
+// where the wiper ends up amt steps from pos, the chip stops at either end
+uint8_t X9C::_stepped(uint8_t pos,uint16_t amt,uint8_t dir){
+  if (dir == X9C_UP)
+    return (pos+amt > X9C_MAX) ? X9C_MAX:pos+amt;
+  return (amt > pos) ? 0:pos-amt;
 }
 
 void X9C::setPot(uint8_t pos,bool save){
   _stepPot(X9C_MAX+1,X9C_DOWN);       // crank it back to (beyond!) "zero" (usu. abt 300R for a 100k [104] pot)
   _stepPot(pos,X9C_UP);       	      // put it at abs value of where we want it...
   save ? _deselectAndSave():_deselectNoSave();
+  _pos=_stepped(0,save ? pos:pos+1,X9C_UP);
 }
 
 void X9C::setPotMax(bool save){
   _stepPot(X9C_MAX+1,X9C_UP);         // crank it up to (beyond!) max
   save ? _deselectAndSave():_deselectNoSave();
+  _pos=X9C_MAX;
 }
   
 void X9C::setPotMin(bool save){
   _stepPot(X9C_MAX+1,X9C_DOWN);       // crank it back to (beyond!) "zero" (usu. abt 300R for a 100k [104] pot)
   save ? _deselectAndSave():_deselectNoSave();  
+  _pos=0;
 }
   
 void X9C::trimPot(uint8_t amt,uint8_t dir,bool save){
   _stepPot(amt,dir);
   save ? _deselectAndSave():_deselectNoSave();
+  if (_pos != X9C_UNKNOWN)
+    _pos=_stepped(_pos,(amt > X9C_MAX ? X9C_MAX:amt)+(save ? 0:1),dir);
+}
+
+uint16_t X9C::_readAdc(){
+  uint16_t sum=0;
+  uint8_t  i;
+
+  for (i=0;i<X9C_READBACK_SAMPLES;i++)
+    sum+=analogRead(_adc);
+  return sum/X9C_READBACK_SAMPLES;
+}
+
+// wiper level for pos: the leg against the head unit's pull-up, R/(Rpu+R), bends over towards the top, normalised
+// to 1 at X9C_MAX and scaled by the calibration
+uint16_t X9C::_expected(uint8_t pos){
+  uint32_t num=(uint32_t)pos*(X9C_READBACK_PULLUP_KOHM+X9C_KOHM);
+  uint32_t den=(uint32_t)X9C_MAX*X9C_READBACK_PULLUP_KOHM+(uint32_t)pos*X9C_KOHM;
+  uint32_t level=_adcHome+(uint64_t)_adcGain*num/den;
+
+  return (level > 1023) ? 1023:level;
+}
+
+void X9C::setReadback(uint8_t adc){
+  uint8_t  cal;
+  uint16_t level;
+  uint32_t num, den;
+
+  _adc=adc;
+  setPotMin(false);
+  _adcHome=_readAdc();
+  setPot(X9C_READBACK_CAL_POS,false);
+  cal=_pos;                           // the no save deselect put it a step past
+  level=_readAdc();
+  num=(uint32_t)cal*(X9C_READBACK_PULLUP_KOHM+X9C_KOHM);
+  den=(uint32_t)X9C_MAX*X9C_READBACK_PULLUP_KOHM+(uint32_t)cal*X9C_KOHM;
+  _adcGain=(level > _adcHome) ? (uint64_t)(level-_adcHome)*den/num:1023;
+  setPotMax(false);
+}
+
+// within half the step to the nearer neighbour, at the saturated top end the neighbours all read 1023
+bool X9C::verify(uint8_t pos){
+  uint16_t level, expected, step=0xFFFF;
+  int16_t  diff, tolerance;
+
+  if (_adc == X9C_NO_READBACK)
+    return true;
+  expected=_expected(pos);
+  if (pos > 0)
+    step=expected-_expected(pos-1);
+  if (pos < X9C_MAX && _expected(pos+1)-expected < step)
+    step=_expected(pos+1)-expected;
+  tolerance=(step/2 > X9C_READBACK_MIN_TOLERANCE) ? step/2:X9C_READBACK_MIN_TOLERANCE;
+
+  level=_readAdc();
+  diff=(int16_t)level-(int16_t)expected;
+  _verifies++;
+  return diff <= tolerance && diff >= -tolerance;
+}
+
+// lands where setPot(pos,save) would, stepping only the difference
+bool X9C::moveTo(uint8_t pos,bool save){
+  uint8_t target, steps;
+
+  if (pos > X9C_MAX)
+    pos=X9C_MAX;
+  if (_adc == X9C_NO_READBACK || _pos == X9C_UNKNOWN){
+    setPot(pos,save);                 // open loop, nothing to start from
+    return true;
+  }
+
+  target=_stepped(pos,save ? 0:1,X9C_UP);
+  if (target != _pos){
+    steps=(target > _pos) ? target-_pos:_pos-target;
+    _stepPot(save ? steps:steps-1,(target > _pos) ? X9C_UP:X9C_DOWN);   // the no save deselect makes the last step
+    save ? _deselectAndSave():_deselectNoSave();
+    _pos=target;
+  }
+  if (verify(_pos))
+    return true;
+
+  _mismatches++;                      // missed / extra pulse somewhere, start again from a known end
+  setPot(pos,save);
+  return false;
+}
+
+void X9CPair::begin(uint8_t csA,uint8_t csB,uint8_t inc,uint8_t ud,uint8_t sel){
+  _sel=sel;
+  _pot[0].begin(csA,inc,ud);
+  _pot[1].begin(csB,inc,ud);        // INC/UD are shared, a pot ignores them while its CS is high
+  X9C_WRITE(csA,HIGH);
+  X9C_WRITE(csB,HIGH);
+
+  pinMode(_sel,OUTPUT);
+#ifdef X9C_TRACE
+  x9cTrace.addSignal(_sel,X9C_SIG_SEL);
+#endif
+  _active=0;
+  X9C_WRITE(_sel,LOW);
+}
+
+void X9CPair::setPotMax(bool save){
+  _active=0;                          // homing gets no exception, each pot is parked while the other one is shown
+  X9C_WRITE(_sel,LOW);
+  _pot[1].setPotMax(save);
+  X9C_WRITE(_sel,HIGH);
+  _pot[0].setPotMax(save);
+  X9C_WRITE(_sel,LOW);
+  _pos[0]=_pos[1]=X9C_MAX;
+}
+
+void X9CPair::_setHidden(uint8_t which,uint8_t pos){
+  if (which == _active){
+    _refused++;                       // would be visible to the head unit, refuse
+    return;
+  }
+  _pot[which].setPot(pos,false);
+  _pos[which]=pos;
+  _stages++;
+}
+
+void X9CPair::stage(uint8_t pos){
+  if (_pos[!_active] != pos)
+    _setHidden(!_active,pos);
+}
+
+void X9CPair::present(){
+  _active=!_active;
+  X9C_WRITE(_sel,_active ? HIGH:LOW);
+  _flips++;
 }
-
@@ -0,0 +1,198 @@
+#include "X9CTrace.h"
+
+#ifdef X9C_TRACE
+
+X9CTrace x9cTrace;
+
+static const char *X9CSignalNames[] = { "cs", "inc", "ud", "sel" };
+
+void X9CTrace::addSignal(uint8_t pin,uint8_t role){
+  if (_signal(pin) >= 0 || _signals >= X9C_TRACE_SIGNALS)
+    return;                           // shared INC/UD get registered by both pots of a pair
+  _pins[_signals]=pin;
+  _roles[_signals]=role;
+  _signals++;
+}
+
+int8_t X9CTrace::_signal(uint8_t pin) const {
+  uint8_t i;
+
+  for (i=0;i<_signals;i++)
+    if (_pins[i] == pin)
+      return i;
+  return -1;
+}
+
+// ns since the first event, the cycle deltas are accumulated so the 53s counter wrap doesn't matter
+static uint64_t advance(uint64_t &elapsed,uint32_t &prev,uint32_t cycles){
+  elapsed+=cycles-prev;
+  prev=cycles;
+  return elapsed*1000/ESP.getCpuFreqMHz();
+}
+
+// String has no 64 bit concatenation and ns since the first event pass 2^32 after 4.3s
+static String u64(uint64_t v){
+  char buf[21], *p=buf+sizeof(buf)-1;
+
+  *p='\0';
+  do {
+    *--p='0'+v%10;
+    v/=10;
+  } while(v);
+  return String(p);
+}
+
+static uint16_t violations;
+
+static void violation(const char *what,uint64_t at,uint64_t got,uint32_t min){
+  if (violations++ < X9C_TRACE_MAX_REPORTED)
+    Serial.println((String)"  X9C "+what+" at_ns="+u64(at)+" got_ns="+u64(got)+" min_ns="+min);
+}
+
+static void busyReport(int16_t cmd,uint64_t busy){
+  if (cmd >= 0)
+    Serial.println((String)"  cmd "+cmd+" bus_busy_us="+(uint32_t)(busy/1000));
+}
+
+// CS state is kept per signal, the pots of a pair are separate chips, one being selected right after the other's
+// store is fine.  INC/UD are shared so their timing is checked against whichever chip is selected.
+void X9CTrace::_check(){
+  uint16_t i;
+  uint64_t t, elapsed=0, tUD=0, tIncFall=0, tIncRise=0, busy=0;
+  uint64_t tCsRise[X9C_TRACE_SIGNALS]={}, tCsFall[X9C_TRACE_SIGNALS]={};
+  uint32_t prev;
+  bool     stored[X9C_TRACE_SIGNALS]={}, deselectedOnce[X9C_TRACE_SIGNALS]={};
+  bool     incLow=false, udChanged=false, firstInc=false, pair=false;
+  int16_t  cmd=-1;
+  int8_t   s, selected=-1, chip[X9C_TRACE_SIGNALS];
+  uint16_t liveInc=0;
+  uint8_t  chips=0;
+
+  for (s=0;s<_signals;s++){
+    chip[s]=(_roles[s] == X9C_SIG_CS) ? chips++:-1;
+    if (_roles[s] == X9C_SIG_SEL)
+      pair=true;
+  }
+
+  violations=0;
+  if (!_count)
+    return;
+  prev=_events[0].cycles;
+
+  for (i=0;i<_count;i++){
+    const X9CTraceEvent &e=_events[i];
+    t=advance(elapsed,prev,e.cycles);
+
+    if (e.pin == X9C_TRACE_MARK){
+      busyReport(cmd,busy);
+      cmd=e.level;
+      busy=0;
+      continue;
+    }
+    if ((s=_signal(e.pin)) < 0)
+      continue;
+
+    switch(_roles[s]){
+      case X9C_SIG_CS:
+        if (e.level == LOW){
+          if (deselectedOnce[s] && t-tCsRise[s] < (stored[s] ? X9C_T_CPH_STORE:X9C_T_CPH))
+            violation(stored[s] ? "tCPH(store)":"tCPH",t,t-tCsRise[s],stored[s] ? X9C_T_CPH_STORE:X9C_T_CPH);
+          selected=s;
+          firstInc=true;
+          tCsFall[s]=t;
+        }
+        else if (selected == s){
+          if (tIncRise > tCsFall[s] && t-tIncRise < X9C_T_IW)
+            violation("tIW",t,t-tIncRise,X9C_T_IW);
+          if (!incLow && t-tIncRise < X9C_T_IC)
+            violation("tIC",t,t-tIncRise,X9C_T_IC);
+          stored[s]=!incLow;          // CS rising with INC high stores the wiper
+          selected=-1;
+          deselectedOnce[s]=true;
+          tCsRise[s]=t;
+          busy+=t-tCsFall[s];
+        }
+        break;
+      case X9C_SIG_INC:
+        if (e.level == LOW){
+          if (selected >= 0){
+            if (firstInc && t-tCsFall[selected] < X9C_T_CI)
+              violation("tCI",t,t-tCsFall[selected],X9C_T_CI);
+            if (!firstInc && t-tIncRise < X9C_T_IH)
+              violation("tIH",t,t-tIncRise,X9C_T_IH);
+            if (udChanged && t-tUD < X9C_T_DI)
+              violation("tDI",t,t-tUD,X9C_T_DI);
+            firstInc=false;
+            udChanged=false;
+            if (pair && chip[selected] == _presented && liveInc++ < X9C_TRACE_MAX_REPORTED)
+              Serial.println((String)"  X9C INC on the presented pot at_ns="+u64(t));
+          }
+          incLow=true;
+          tIncFall=t;
+        }
+        else{
+          if (selected >= 0 && t-tIncFall < X9C_T_IL)
+            violation("tIL",t,t-tIncFall,X9C_T_IL);
+          incLow=false;
+          tIncRise=t;
+        }
+        break;
+      case X9C_SIG_UD:
+        udChanged=true;
+        tUD=t;
+        break;
+      case X9C_SIG_SEL:
+        _presented=e.level ? 1:0;
+        break;
+    }
+  }
+  busyReport(cmd,busy);
+  if (violations > X9C_TRACE_MAX_REPORTED)
+    Serial.println((String)"  X9C "+(violations-X9C_TRACE_MAX_REPORTED)+" more violations not listed");
+  if (pair)
+    Serial.println((String)"  X9C live_inc="+liveInc);
+}
+
+void X9CTrace::_dumpVCD(){
+  uint16_t i;
+  uint8_t  s;
+  uint64_t t, elapsed=0;
+  uint32_t prev=_events[0].cycles;
+
+  Serial.println("$vcd-begin");
+  Serial.println("$timescale 1ns $end");
+  Serial.println("$scope module x9c $end");
+  for (s=0;s<_signals;s++)
+    Serial.println((String)"$var wire 1 "+(char)('a'+s)+" "+X9CSignalNames[_roles[s]]+"_gpio"+_pins[s]+" $end");
+  Serial.println("$var integer 8 m command $end");
+  Serial.println("$upscope $end");
+  Serial.println("$enddefinitions $end");
+
+  for (i=0;i<_count;i++){
+    const X9CTraceEvent &e=_events[i];
+    t=advance(elapsed,prev,e.cycles);
+    Serial.println("#"+u64(t));
+    if (e.pin == X9C_TRACE_MARK){
+      String bits;
+      for (s=8;s--;)
+        bits+=((e.level >> s) & 1) ? '1':'0';
+      Serial.println("b"+bits+" m");
+    }
+    else if (_signal(e.pin) >= 0)
+      Serial.println((String)(e.level ? "1":"0")+(char)('a'+_signal(e.pin)));
+    yield();                          // this is a long dump at 9600 baud
+  }
+  Serial.println("$vcd-end");
+}
+
+void X9CTrace::report(){
+  Serial.println((String)"X9C trace events="+_count);
+  _check();
+  if (_dumpArmed){
+    _dumpVCD();
+    _dumpArmed=false;
+  }
+  clear();
+}
+
+#endif // X9C_TRACE
@@ -1,6 +1,19 @@
 #include <Arduino.h>
-#include <Encoder.h>
+#include <ESP8266WiFi.h>
+#include <EEPROM.h>
 #include "X9C.h"
+#include "RadioProfile.h"
+#include "TimingModel.h"
+#include "QuadratureEncoder.h"
+#include "X9CTrace.h"
+#include "CommandQueue.h"
+#include "IdleGovernor.h"
+#include "LoopMonitor.h"
+#include "Profiler.h"
+#include "ButtonLadder.h"
+#include "InputRouter.h"
+#include "PushButton.h"
+#include "RadioTasks.h"
 #include "pt.h"
 
 // Pins for Rotatary Encoder
@@ -8,298 +21,288 @@
 #define             dtPin                          D1
 #define             swPin                          D3
 
+// Steering wheel button ladder (optional, -DLADDER_ENABLED)
+#define             ladderPin                      A0
+// Pot wiper readback (optional, -DX9C_READBACK)
+#define             wiperPin                       A0
+
+#if defined(X9C_READBACK) && defined(LADDER_ENABLED)
+#error "X9C_READBACK and LADDER_ENABLED both need A0, the ESP8266 only has the one ADC"
+#endif
+#if defined(X9C_READBACK) && defined(X9C_PINGPONG)
+#error "X9C_READBACK can only watch a single pot, the staged pot of a pair isn't on the output"
+#endif
+
 // Pins for digital Pot
 #define             CS                             D4
 #define             UD                             D5
 #define             INC                            D6
+#define             CS2                            D7         // second pot and the analog switch select, only with -DX9C_PINGPONG
+#define             potSelect                      D0
 
-// 20200714 -- you must now place the defines for anything that causes the Pioneer VolumeScreen to come up first and contiguous so that SCREENRANGE is < all of them
-#define VOLUMEUP      1
-#define VOLUMEDOWN    2
-#define MUTE          3         // mute can be implemented as the button MUTE or PLAY/PAUSE which would allow Navigation to continue, I usually opt for that method
-#define SCREENRANGE   4
-
-#define TRACKFF       4
-#define TRACKPV       5
-#define TRIPLECLICK   6       // unsure what this does, mostly testing right now
-
-// in the case of the X9C pot, its a percentage and the 104 is 100K with 100 steps so each step is 1000 Ohm or 1K so you just set the percentage directly
-//
-
-#define REST_VOLUMEUP                              16
-#define REST_VOLUMEDOWN                            24
-#define REST_TRACKFF                               7
-#define REST_MUTE                                  3.5
-#define REST_TRACKPV                               10
-#define REST_TRIPLECLICK                           0
+// EEPROM marker that the X9C NVRAM already holds the idle (max) wiper position
+#define POT_HOMED_ADDR                             0
+#define POT_HOMED_MAGIC                            0xA5
 
 // time vars
-static int          MinSliceDelay                 = 1;
-static int          DeBounceDelay                 = 10;          // this is hardware/software loop centric, for my setup and loop() 1 seems to be working well
-
-
-// Threading times                                              //  libraries scheduler seem to need different CPUs, and protothread seemed to involved, so just did a simple wait schedule with anti-stravation
-static int          WaitForUnitToComplete         = 41;         // so far it looks like the Pioneer might need 40msec to respond to the event
-static int          WaitForDisplayTime            = 850;        // was 650        // this should be the minimum time to display the screen
-static int          WaitTimeForBetweenScreens     = 4100;       // this should be the minimum time for the volume screen to remove after no other commands have been sent
-
-// ProtoThreads
-static struct pt pt1, pt2;                                      // 2 threads, the encodes pt1 thread, and the writing of commands (the POT setter) pt2
-
-// ProtoThread Queue
-#define               QUEUEMAXSIZE  200
-int                   QueueCommands[QUEUEMAXSIZE];
-int                   QueueIndex=0;
-int                   QueueLastProc=0;
-static int            LoopOfThread                  = 0;
-static int            CurLimit                      = 0;
-
-Encoder myEnc(dtPin, clkPin);
-
-X9C pot;  //  100 KΩ
-
-int counter = 0;
-int lastVolumeCount = 0;
+static unsigned long IdleReportTime               = 60000;      // how often the idle governor, loop monitor (and profile) stats are printed
+
+QuadratureEncoder myEnc;
+
+OutputPot pot;
+
+
+static EncoderTask      encoderTask;
+#ifdef ENCODER2_A
+static EncoderTask      encoder2Task;
+QuadratureEncoder       myEnc2;
+#endif
+
+InputRouter router;
+PushButton button;
+static DispatchTask     dispatchTask;
+
+// every instance the idle check has to wait on, a new encoder or dispatcher goes in here as well as in loop()
+static EncoderTask     *Encoders[]    = { &encoderTask,
+#ifdef ENCODER2_A
+                                          &encoder2Task,
+#endif
+                                        };
+static DispatchTask    *Dispatchers[] = { &dispatchTask };
+
+IdleGovernor governor;
+LoopMonitor monitor;
+
+#ifdef LADDER_ENABLED
+// ADC windows for the steering wheel ladder, pick the vehicle with -DLADDER_VEHICLE=n.  The ladder shares one pull-up
+// to 3.3V so an idle ladder reads near 1023, outside every window.  Windows are about +-40 counts around the
+// nominal reading to cover resistor tolerance and the D1 mini's A0 divider.
+#ifndef LADDER_VEHICLE
+#define LADDER_VEHICLE 1
+#endif
+
+#if LADDER_VEHICLE == 1
+// generic 5 button ladder, 2.2K pull-up, buttons 0R / 330R / 680R / 1K2 / 2K2 to ground
+static const LadderButton LadderTable[] = {
+  {   0,  50, VOLUMEUP,   0, LADDER_REPEAT },
+  {  95, 170, VOLUMEDOWN, 0, LADDER_REPEAT },
+  { 200, 290, TRACKFF,    0, LADDER_ONCE   },
+  { 315, 420, TRACKPV,    0, LADDER_ONCE   },
+  { 450, 580, MUTE,       0, LADDER_ONCE   },
+};
+#else
+#error "Unknown LADDER_VEHICLE, add its threshold table"
+#endif
+static_assert(sizeof(LadderTable) / sizeof(LadderTable[0]) <= INPUT_LADDER_BUTTONS, "more ladder buttons than INPUT_LADDER rows");
+
+ButtonLadder ladder;
+static LadderTask ladderTask;
+#endif
 
 int volume = 0;
 
-long buttonPressMillis = 0;
-
-void IncreaseQueueIndex()
-{
-    QueueIndex++;
-    if (QueueIndex > QUEUEMAXSIZE)
-      QueueIndex=0;
-}
+unsigned long BootReadyMicros = 0;
 
 void ClearQueue()
 {
   //init the queue, (not really needed but just in case)
-  static int clearloop=0;
-  CurLimit=0;
-  LoopOfThread=0;
-  QueueIndex=0;
-  QueueLastProc=0;
-  for (clearloop=0;clearloop<=QUEUEMAXSIZE;clearloop++)
-     QueueCommands[clearloop]=0;
-
+  Queue.clear();
 }
 
-//  commands
-void PulseVolumeUp()
-{
-  QueueCommands[QueueIndex]=VOLUMEUP;
-  IncreaseQueueIndex();
-  Serial.println("PULSE-UP");
-}
-void PulseVolumeDown()
-{
-  QueueCommands[QueueIndex]=VOLUMEDOWN;
-  IncreaseQueueIndex();
-  Serial.println("PULSE-DOWN");
-}
-void PulseTrackForward(void)
+
+// encoder detent / button release ISR hook, get the loop out of its idle sleep
+ICACHE_RAM_ATTR void inputWake()
 {
-  QueueCommands[QueueIndex]=TRACKFF;
-  IncreaseQueueIndex();
-  Serial.println("PULSE-FF");
+  governor.wake();
 }
-void PulseTrackBack(void)
+
+// default control layout, anything not bound here is ignored by the router
+void BindInputs()
 {
-  QueueCommands[QueueIndex]=TRACKPV;
-  IncreaseQueueIndex();
-  Serial.println("PULSE-PV");
+  router.begin(PulseCommand);
+  router.bind(INPUT_ENCODER0, INPUT_STEP_UP,    VOLUMEUP);
+  router.bind(INPUT_ENCODER0, INPUT_STEP_DOWN,  VOLUMEDOWN);
+  router.bind(INPUT_BUTTON0,  INPUT_PRESS,      MUTE);
+  router.bind(INPUT_BUTTON0,  INPUT_LONG_PRESS, TRACKFF);
+  router.bind(INPUT_ENCODER1, INPUT_STEP_UP,    TRACKFF);
+  router.bind(INPUT_ENCODER1, INPUT_STEP_DOWN,  TRACKPV);
+#ifdef LADDER_ENABLED
+  for (uint8_t i = 0; i < sizeof(LadderTable) / sizeof(LadderTable[0]); i++)
+  {
+    router.bind(INPUT_LADDER, INPUT_PRESS,      LadderTable[i].command,     i);
+    router.bind(INPUT_LADDER, INPUT_LONG_PRESS, LadderTable[i].holdCommand, i);
+  }
+#endif
 }
-void PulseMute(void)
+
+// nothing queued, no dispatcher timer running and no encoder movement an EncoderTask hasn't seen yet
+static bool TasksIdle()
 {
-  QueueCommands[QueueIndex]=MUTE;
-  IncreaseQueueIndex();
-  Serial.println("PULSE-MUTE");
+  for (EncoderTask *t : Encoders)
+    if (t->encoder->read() != t->counter)
+      return false;
+  for (DispatchTask *t : Dispatchers)
+    if (!t->queue->empty() || t->Busy)
+      return false;
+  return true;
 }
-void PulseTripleClick(void)
+
+// runs before the SDK starts, keeps the core from bringing WiFi up from its saved config, we never use the radio
+void preinit()
 {
-  QueueCommands[QueueIndex]=TRIPLECLICK;
-  IncreaseQueueIndex();
-  Serial.println("PULSE-TRIPLE");
+  ESP8266WiFiClass::preinitWiFiOff();
 }
 
-ICACHE_RAM_ATTR void buttonPressed()
+// The X9C restores its wiper from NVRAM at power up, and max (idle) is the only position ever saved to it (the
+// homing below and the release after each command), so once it has been stored the wiper already comes up at idle.
+// Later boots only re-assert max without a store, which can't move an already parked wiper, so there's nothing for
+// the head unit to settle on and no wait is needed.
+// returns true when the full save + settle had to be done
+bool HomePot()
 {
-  long now = millis();
+  bool fullHome = false;
 
-  if (now - buttonPressMillis < 100)
+  EEPROM.begin(4);
+  if (EEPROM.read(POT_HOMED_ADDR) == POT_HOMED_MAGIC)
   {
-    // Debounce
-    return;
+    pot.setPotMax(false);
   }
-
-  PulseMute();
-
-  buttonPressMillis = millis();
-}
-
-
-static int protothread1(struct pt *pt)
-{
-  static unsigned long timestamp            = 0;
-
-  PT_BEGIN(pt);
-
-  while(1)
+  else
   {
-    counter = myEnc.read();
-
-    if (counter - lastVolumeCount > 1)
-    {
-      PulseVolumeUp();
-      lastVolumeCount = counter;
-    }
-    else if (counter - lastVolumeCount < -1)
-    {
-      PulseVolumeDown();
-      lastVolumeCount = counter;
-    }
-
-    timestamp = millis(); PT_WAIT_UNTIL(pt, millis() - timestamp > MinSliceDelay);                        // allow other thread some time
+    pot.setPotMax(true);
+    delay(WaitForUnitToComplete);
+    EEPROM.write(POT_HOMED_ADDR, POT_HOMED_MAGIC);
+    EEPROM.commit();
+    fullHome = true;
   }
+  EEPROM.end();
 
-  PT_END(pt);
+  return fullHome;
 }
 
-
-static int protothread2(struct pt *pt)
+void setup()
 {
-  static unsigned long  timestamp                      = 0;
-  static uint16_t       Command                        = 0;
-  static unsigned long  PreviousCommandTimeStamp       = 0;
-  static bool           WaitForDisplay                 = false;
-  static unsigned long  TimeWhenInQueue                = 0;
-  static bool           InsideAQueueProcess            = false;
-  static int            TempCommand                    = 0;
+  bool fullHome;
 
-  PT_BEGIN(pt);
+  // the queue has to be ready before the inputs start, a press while the pot is homing is kept
+  ClearQueue();
+  Serial.begin(9600);
 
-  while(1)
-  {
-    Command=0;
-    CurLimit=QueueIndex;
-    if (CurLimit<QueueLastProc)
-    {
-      CurLimit=CurLimit+QUEUEMAXSIZE;
-    }
-
-    if (QueueLastProc != CurLimit)
-    {
-      Serial.println((String)"QueueIndex="+QueueIndex+" QueueLastProc="+QueueLastProc+ " CurLimit="+CurLimit+" LoopOfThread="+LoopOfThread);
-      for (LoopOfThread = QueueLastProc; LoopOfThread < CurLimit; LoopOfThread++)
-      {
-          Command=0;
-          switch(QueueCommands[LoopOfThread%QUEUEMAXSIZE])
-          {
-            case VOLUMEUP:
-              Command = REST_VOLUMEUP;
-              Serial.print("UP ");
-              break;
-            case VOLUMEDOWN:
-              Command = REST_VOLUMEDOWN;
-              Serial.print("DOWN ");
-              break;
-            case TRACKFF:
-              Command = REST_TRACKFF;
-              Serial.print("FF ");
-              break;
-            case TRACKPV:
-              Command = REST_TRACKPV;
-              Serial.print("PV ");
-              break;
-            case MUTE:
-              Command = REST_MUTE;
-              Serial.print("MUTE ");
-              break;
-            case 0:
-              Serial.println("I hit 0");
-              Command = 0;
-              break;
-            default:
-              Serial.println((String)"Dont think I should hit these QueueIndex="+QueueIndex+" QueueLastProc="+QueueLastProc+ " CurLimit="+CurLimit);
-              Command=0;
-              timestamp = millis(); PT_WAIT_UNTIL(pt, millis() - timestamp > DeBounceDelay);
-              break;
-          }
-          TempCommand = QueueCommands[LoopOfThread%QUEUEMAXSIZE];
-          QueueCommands[LoopOfThread%QUEUEMAXSIZE]=0;
-
-          if (Command != 0)
-          {
-              timestamp = millis();
-              if (timestamp-PreviousCommandTimeStamp > WaitTimeForBetweenScreens && !InsideAQueueProcess && TempCommand < SCREENRANGE)    // SCREENRANGE must be +1 then ALL display impacting cases
-              {
-                PreviousCommandTimeStamp = timestamp;
-                WaitForDisplay=true;
-              }
-
-              InsideAQueueProcess=true;
-              TimeWhenInQueue = millis();
-
-
-              pot.setPot(Command,false);
-              timestamp = millis(); PT_WAIT_UNTIL(pt, millis() - timestamp > WaitForUnitToComplete);                       // allow stereo time to handle the input
-              Serial.println("CommandDone");
-
-              pot.setPotMax(true);
-              timestamp = millis(); PT_WAIT_UNTIL(pt, millis() - timestamp > WaitForUnitToComplete);                       // allow stereo time to handle the input
-
-              if (WaitForDisplay)
-              {
-                  Serial.println("Waiting for Screen");
-                  WaitForDisplay = false;
-                  timestamp = millis(); PT_WAIT_UNTIL(pt, millis() - timestamp > WaitForDisplayTime);                // allow stereo time to handle the input
-                  Serial.println("Screen should be up, do any other commands");
-              }
-          }
-          Command=0;
-      } // when the for-next loop is done (all the commands on the queue)
-      QueueLastProc=CurLimit%QUEUEMAXSIZE;
-    }
-    else // if you are here there was no messages in the queue
-    {
-      timestamp = millis();
-      if (timestamp-TimeWhenInQueue > WaitTimeForBetweenScreens)
-      {
-          if (InsideAQueueProcess)
-            Serial.println("The screen is no longer on ");
-          InsideAQueueProcess=false;
-      }
-    }
-    timestamp = millis(); PT_WAIT_UNTIL(pt, millis() - timestamp > MinSliceDelay);                                // allow other thread some time
-  }
-  PT_END(pt);
-}
+  BindInputs();
 
+  // A/B swapped against the old Encoder(dtPin, clkPin) so clockwise still counts up
+  myEnc.begin(clkPin, dtPin, QUAD_MIN_EDGE_US, inputWake);
+#ifdef ENCODER2_A
+  myEnc2.begin(ENCODER2_A, ENCODER2_B, QUAD_MIN_EDGE_US, inputWake);
+#endif
 
-void setup()
-{
   // Setup pushbutton on Encoder
-  pinMode(swPin, INPUT_PULLUP);
-  attachInterrupt(swPin, buttonPressed, RISING);
+  button.begin(swPin, &router, INPUT_BUTTON0, BUTTON_DEBOUNCE_MS, inputWake);
 
   // setup POT
+#ifdef X9C_PINGPONG
+  pot.begin(CS, CS2, INC, UD, potSelect);
+#else
   pot.begin(CS, INC, UD);
+#endif
   delay(1);
-  pot.setPotMax(true);
-  delay(WaitForUnitToComplete);
-
-  // clear the queue, I believe this can be removed since the units memory starts zero'ed, (I remember reading that somewhere)
-  ClearQueue();
+  fullHome = HomePot();
+#ifdef X9C_READBACK
+  pot.setReadback(wiperPin);
+  if (!pot.moveTo(X9C_MAX, false))
+    fullHome = true;                                            // NVRAM didn't come back at idle, moveTo re-homed
+#endif
+
+  EncoderTaskInit(&encoderTask, &myEnc, &router, INPUT_ENCODER0);
+#ifdef ENCODER2_A
+  EncoderTaskInit(&encoder2Task, &myEnc2, &router, INPUT_ENCODER1);
+#endif
+  DispatchTaskInit(&dispatchTask, &Queue, &pot);
+#ifdef LADDER_ENABLED
+  ladder.begin(ladderPin, LadderTable, sizeof(LadderTable) / sizeof(LadderTable[0]));
+  LadderTaskInit(&ladderTask, &ladder, &router);
+#endif
+
+  BootReadyMicros = micros();                                   // from here the protothreads take commands
 
-  Serial.begin(9600);
   Serial.println();
+  Serial.println((String)"Boot ready_us="+BootReadyMicros+" home="+(fullHome ? "full" : "nvram")+" reset="+ESP.getResetReason());
+  Serial.println((String)"Queue capacity="+Queue.capacity()+" bytes="+sizeof(Queue));
 }
 
 void loop()
 {
-  protothread1(&pt1);
-  protothread2(&pt2);
+  static unsigned long lastIdleReport = 0;
+  static unsigned long lastPass = 0;
+  unsigned long gap = millis() - lastPass;
+  uint16_t expired;
+
+  // a pass that stalled past the longest TTL (the VCD dump) leaves nothing worth playing, and could leave entries
+  // older than the queue's age stamps can tell, clear it before the producers add anything new
+  lastPass += gap;
+  if (gap > TimingModel::stallExpireUs() / 1000 && (expired = DispatchTaskExpire(&dispatchTask)) != 0)
+    Serial.println((String)"Stall ms="+gap+" expired="+expired);
+
+  monitor.beginLoop();
+  monitor.beginThread(&encoderTask.pt);
+  PROFILE_RUN(PROFILE_ENCODER, protothread1(&encoderTask));
+  monitor.endThread(1, &encoderTask.pt);
+#ifdef ENCODER2_A
+  monitor.beginThread(&encoder2Task.pt);
+  PROFILE_RUN(PROFILE_ENCODER, protothread1(&encoder2Task));
+  monitor.endThread(4, &encoder2Task.pt);
+#endif
+  monitor.beginThread(&dispatchTask.pt);
+  PROFILE_RUN(PROFILE_DISPATCH, protothread2(&dispatchTask));
+  monitor.endThread(2, &dispatchTask.pt);
+#ifdef LADDER_ENABLED
+  monitor.beginThread(&ladderTask.pt);
+  PROFILE_RUN(PROFILE_LADDER, protothread3(&ladderTask));
+  monitor.endThread(3, &ladderTask.pt);
+#endif
+  button.service();
+
+#ifdef X9C_TRACE
+  monitor.beginThread(NULL);
+  if (Serial.available() && Serial.read() == X9C_TRACE_DUMP_KEY)
+    x9cTrace.armDump();                                         // the next full capture is also dumped as a VCD
+  if (x9cTrace.full())
+    x9cTrace.report();
+  monitor.endThread(LOOP_SECTION_TRACE, NULL);
+#endif
+
+  if (millis() - lastIdleReport > IdleReportTime)
+  {
+    monitor.beginThread(NULL);
+    lastIdleReport = millis();
+    governor.report();
+    governor.resetStats();
+    monitor.report();
+    monitor.resetStats();
+    myEnc.report();
+    myEnc.resetStats();
+    PROFILE_REPORT();
+    for (uint8_t cmd = 1; cmd < COMMAND_CODES; cmd++)
+      if (dispatchTask.Expired[cmd])
+        Serial.println((String)"Expired cmd="+cmd+" count="+dispatchTask.Expired[cmd]);
+    memset(dispatchTask.Expired, 0, sizeof(dispatchTask.Expired));
+#ifdef X9C_READBACK
+    Serial.println((String)"Readback verifies="+pot.verifies()+" mismatches="+pot.mismatches());
+#endif
+#ifdef X9C_PINGPONG
+    Serial.println((String)"PingPong flips="+pot.flips()+" stages="+pot.stages()+" refused="+pot.refused());
+#endif
+#ifdef LADDER_ENABLED
+    ladder.report();
+    ladder.resetStats();
+#endif
+    monitor.endThread(LOOP_SECTION_REPORT, NULL);                 // lands in the next window's stats
+  }
+
+  monitor.endLoop();                                            // the serial sections above count towards the pass
+
+  if (TasksIdle() && !button.pending())
+    governor.sleep();
 
   //noInterrupts();
 
@@ -0,0 +1,53 @@
+#ifndef X9CMODEL_H
+#define X9CMODEL_H
+//
+// Pin level model of the X9C for the native tests, fed from NativeArduino::onWrite.  A falling INC while the chip's
+// CS is low moves the wiper one step (U/D low is up), clamped at both ends like the chip.  A pair of these behind a
+// SEL line gives the head unit's view: the presented wiper, and every time it moved for any reason but a SEL flip.
+//
+#include <Arduino.h>
+#include "X9C.h"
+
+struct X9CModel {
+  uint8_t  cs, inc, ud;
+  int      wiper;
+  uint32_t steps;
+
+  void begin(uint8_t csPin,uint8_t incPin,uint8_t udPin,int powerUp){
+    cs=csPin;
+    inc=incPin;
+    ud=udPin;
+    wiper=powerUp;
+    steps=0;
+  }
+
+  // before the write lands, the pin's old level is still in NativeArduino::output()
+  void write(uint8_t pin,uint8_t level){
+    if (pin != inc || level != LOW || NativeArduino::output(inc) != HIGH || NativeArduino::output(cs) != LOW)
+      return;
+    if (NativeArduino::output(ud) == LOW)
+      wiper=(wiper < X9C_MAX) ? wiper+1:X9C_MAX;
+    else
+      wiper=(wiper > 0) ? wiper-1:0;
+    steps++;
+  }
+};
+
+struct X9CPairModel {
+  X9CModel chip[2];
+  uint8_t  sel;
+  uint32_t liveSteps;                 // presented wiper moved without a flip
+
+  int presented() const { return chip[NativeArduino::output(sel) ? 1:0].wiper; }
+
+  void write(uint8_t pin,uint8_t level){
+    int before=presented();
+
+    chip[0].write(pin,level);
+    chip[1].write(pin,level);
+    if (pin != sel && presented() != before)
+      liveSteps++;
+  }
+};
+
+#endif // X9CMODEL_H
@@ -0,0 +1,133 @@
+//
+// PushButton debounce and press timing ([env:native], BUTTON_DEBOUNCE_MS window).
+//
+// Pin edges go through NativeArduino::setInput() so the ISR sees them like on the target, service() is called the
+// way loop() does.  Every routed event lands in a recording sink bound to MUTE (press) and TRACKFF (long press).
+//
+#include <Arduino.h>
+#include <unity.h>
+#include "PushButton.h"
+#include "RadioProfile.h"
+
+#define PIN         D3
+#define BOUNCE_US   2000                                        // contact chatter, well inside the window
+
+static InputRouter Router;
+static PushButton  Button;
+static uint8_t     Routed[16];
+static uint8_t     RoutedCount;
+static uint32_t    Wakes;
+
+static void sink(uint8_t cmd){
+  if (RoutedCount < sizeof(Routed))
+    Routed[RoutedCount]=cmd;
+  RoutedCount++;
+}
+
+static void onRelease(){ Wakes++; }
+
+// loop() passes every millisecond for ms
+static void runFor(uint32_t ms){
+  for (;ms;ms--){
+    NativeArduino::advance(1000);
+    Button.service();
+  }
+}
+
+static void chatter(uint8_t level){
+  uint8_t i;
+
+  for (i=0;i<3;i++){
+    NativeArduino::setInput(PIN,level);
+    NativeArduino::advance(BOUNCE_US);
+    NativeArduino::setInput(PIN,!level);
+    NativeArduino::advance(BOUNCE_US);
+  }
+  NativeArduino::setInput(PIN,level);
+}
+
+void setUp(){
+  NativeArduino::reset();
+  Router=InputRouter();
+  Router.begin(sink);
+  Router.bind(INPUT_BUTTON0,INPUT_PRESS,MUTE);
+  Router.bind(INPUT_BUTTON0,INPUT_LONG_PRESS,TRACKFF);
+  RoutedCount=0;
+  Wakes=0;
+  Button=PushButton();
+  Button.begin(PIN,&Router,INPUT_BUTTON0,BUTTON_DEBOUNCE_MS,onRelease);
+  runFor(BUTTON_DEBOUNCE_MS);
+}
+
+void tearDown(){}
+
+// chatter on both edges is one press, routed once at release
+void test_bouncy_press_routes_once(){
+  chatter(LOW);
+  runFor(200);
+  TEST_ASSERT_EQUAL_UINT8(0,RoutedCount);
+  chatter(HIGH);
+  runFor(BUTTON_DEBOUNCE_MS);
+
+  TEST_ASSERT_EQUAL_UINT8(1,RoutedCount);
+  TEST_ASSERT_EQUAL_UINT8(MUTE,Routed[0]);
+  TEST_ASSERT_EQUAL_UINT32(1,Wakes);
+  TEST_ASSERT_FALSE(Button.pending());
+  runFor(500);
+  TEST_ASSERT_EQUAL_UINT8(1,RoutedCount);
+}
+
+// held past INPUT_LONG_PRESS_MS is the long press binding
+void test_long_press(){
+  NativeArduino::setInput(PIN,LOW);
+  runFor(INPUT_LONG_PRESS_MS+50);
+  NativeArduino::setInput(PIN,HIGH);
+  runFor(BUTTON_DEBOUNCE_MS);
+
+  TEST_ASSERT_EQUAL_UINT8(1,RoutedCount);
+  TEST_ASSERT_EQUAL_UINT8(TRACKFF,Routed[0]);
+}
+
+// a release right after a press lands inside the window and the ISR drops it, service() resyncs from the pin once
+// it's stable so the tap still counts and the button isn't left stuck down
+void test_tap_inside_window_resyncs(){
+  NativeArduino::setInput(PIN,LOW);
+  NativeArduino::advance(BUTTON_DEBOUNCE_MS*1000UL/2);
+  NativeArduino::setInput(PIN,HIGH);
+  TEST_ASSERT_FALSE(Button.pending());
+  runFor(BUTTON_DEBOUNCE_MS);
+
+  TEST_ASSERT_EQUAL_UINT8(1,RoutedCount);
+  TEST_ASSERT_EQUAL_UINT8(MUTE,Routed[0]);
+
+  NativeArduino::setInput(PIN,LOW);                             // and the next press is seen normally
+  runFor(100);
+  NativeArduino::setInput(PIN,HIGH);
+  runFor(BUTTON_DEBOUNCE_MS);
+  TEST_ASSERT_EQUAL_UINT8(2,RoutedCount);
+}
+
+// a press right after a release, the ISR drops the down edge, service() picks it up
+void test_press_inside_window_resyncs(){
+  NativeArduino::setInput(PIN,LOW);
+  runFor(100);
+  NativeArduino::setInput(PIN,HIGH);
+  NativeArduino::advance(BUTTON_DEBOUNCE_MS*1000UL/2);
+  NativeArduino::setInput(PIN,LOW);
+  runFor(100);
+  TEST_ASSERT_EQUAL_UINT8(1,RoutedCount);
+  NativeArduino::setInput(PIN,HIGH);
+  runFor(BUTTON_DEBOUNCE_MS);
+
+  TEST_ASSERT_EQUAL_UINT8(2,RoutedCount);
+  TEST_ASSERT_EQUAL_UINT8(MUTE,Routed[1]);
+}
+
+int main(int argc,char **argv){
+  UNITY_BEGIN();
+  RUN_TEST(test_bouncy_press_routes_once);
+  RUN_TEST(test_long_press);
+  RUN_TEST(test_tap_inside_window_resyncs);
+  RUN_TEST(test_press_inside_window_resyncs);
+  return UNITY_END();
+}
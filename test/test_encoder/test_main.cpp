@@ -0,0 +1,127 @@
+//
+// QuadratureEncoder edge sequences ([env:native], QUAD_STEPS_PER_COUNT 2, rests at 11 and 00).
+//
+// Each case plays pin edges with the gap before each one, lets the pins settle and checks read().  Forward is A
+// falling first (11 -> 01 -> 00 -> 10 -> 11), a detent per half cycle.  GLITCH_US is well inside QUAD_MIN_EDGE_US,
+// STEP_US is a hand turned edge.
+//
+#include <Arduino.h>
+#include <unity.h>
+#include "QuadratureEncoder.h"
+
+#define PIN_A       D2
+#define PIN_B       D1
+#define STEP_US     2000
+#define GLITCH_US   20
+
+struct QuadEdge {
+  uint8_t  pin;
+  uint8_t  level;
+  uint16_t gapUs;
+};
+
+struct QuadCase {
+  const char     *name;
+  const QuadEdge *edges;
+  uint8_t         count;
+  long            expected;
+};
+
+#define EDGES(e)  e, sizeof(e) / sizeof(e[0])
+
+static const QuadEdge Forward[]={ {PIN_A,LOW,STEP_US}, {PIN_B,LOW,STEP_US}, {PIN_A,HIGH,STEP_US}, {PIN_B,HIGH,STEP_US} };
+static const QuadEdge Reverse[]={ {PIN_B,LOW,STEP_US}, {PIN_A,LOW,STEP_US}, {PIN_B,HIGH,STEP_US}, {PIN_A,HIGH,STEP_US} };
+static const QuadEdge Spike[]={ {PIN_A,LOW,STEP_US}, {PIN_A,HIGH,GLITCH_US} };
+// the glitch's first edge lands after a quiet gap, the one ending it inside the window.  It has to undo its step, or
+// the reverse turn that follows decodes from the wrong state and loses its detent
+static const QuadEdge GlitchReverse[]={ {PIN_A,LOW,STEP_US}, {PIN_A,HIGH,GLITCH_US}, {PIN_B,LOW,STEP_US}, {PIN_A,LOW,STEP_US} };
+static const QuadEdge GlitchForward[]={ {PIN_A,LOW,STEP_US}, {PIN_A,HIGH,GLITCH_US}, {PIN_A,LOW,STEP_US}, {PIN_B,LOW,STEP_US} };
+// reaches the rest, bounces off it and back inside the window: one detent
+static const QuadEdge BounceArrive[]={ {PIN_A,LOW,STEP_US}, {PIN_B,LOW,STEP_US}, {PIN_B,HIGH,GLITCH_US}, {PIN_B,LOW,GLITCH_US} };
+// reaches the rest and bounces off it for good, the step back out cancels the pending detent
+static const QuadEdge BackOff[]={ {PIN_A,LOW,STEP_US}, {PIN_B,LOW,STEP_US}, {PIN_B,HIGH,GLITCH_US}, {PIN_A,HIGH,STEP_US} };
+static const QuadEdge BounceLeave[]={ {PIN_A,LOW,STEP_US}, {PIN_B,LOW,STEP_US}, {PIN_A,HIGH,STEP_US}, {PIN_A,LOW,GLITCH_US},
+                                      {PIN_A,HIGH,GLITCH_US}, {PIN_B,HIGH,STEP_US} };
+
+static const QuadCase Cases[] = {
+  { "forward half cycles",                              EDGES(Forward),        2 },
+  { "reverse half cycles",                              EDGES(Reverse),       -2 },
+  { "spike at rest",                                    EDGES(Spike),          0 },
+  { "glitch ending inside the window, then reverse",   EDGES(GlitchReverse), -1 },
+  { "glitch ending inside the window, then forward",   EDGES(GlitchForward),  1 },
+  { "bounce arriving at the rest",                      EDGES(BounceArrive),   1 },
+  { "touches the rest and backs off",                   EDGES(BackOff),        0 },
+  { "bounce leaving the rest",                          EDGES(BounceLeave),    2 },
+};
+
+static QuadratureEncoder Enc;
+static uint32_t          Wakes;
+
+static void onDetent(){ Wakes++; }
+
+static void play(const QuadEdge *edges,uint8_t count){
+  uint8_t i;
+
+  for (i=0;i<count;i++){
+    NativeArduino::advance(edges[i].gapUs);
+    NativeArduino::setInput(edges[i].pin,edges[i].level);
+  }
+}
+
+void setUp(){
+  NativeArduino::reset();
+  Enc=QuadratureEncoder();
+  Enc.begin(PIN_A,PIN_B,QUAD_MIN_EDGE_US,onDetent);
+  Wakes=0;
+}
+
+void tearDown(){}
+
+void test_edge_sequences(){
+  uint8_t i;
+
+  for (i=0;i<sizeof(Cases)/sizeof(Cases[0]);i++){
+    setUp();
+    play(Cases[i].edges,Cases[i].count);
+    NativeArduino::advance(STEP_US);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(Cases[i].expected,Enc.read(),Cases[i].name);
+  }
+}
+
+// the count at a rest waits for the window, read() right after the edge still has the old count
+void test_detent_waits_for_settled_rest(){
+  static const QuadEdge half[]={ {PIN_A,LOW,STEP_US}, {PIN_B,LOW,STEP_US} };
+
+  play(half,2);
+  TEST_ASSERT_EQUAL_INT(0,Enc.read());
+  TEST_ASSERT_EQUAL_UINT32(1,Wakes);
+  NativeArduino::advance(QUAD_MIN_EDGE_US-1);
+  TEST_ASSERT_EQUAL_INT(0,Enc.read());
+  NativeArduino::advance(1);
+  TEST_ASSERT_EQUAL_INT(1,Enc.read());
+}
+
+// a glitch leaves the decoder in step with the pins, turns after it count normally
+void test_stays_in_sync_after_glitches(){
+  static const QuadEdge turn[]={ {PIN_A,LOW,STEP_US}, {PIN_A,HIGH,GLITCH_US}, {PIN_A,LOW,STEP_US}, {PIN_B,LOW,GLITCH_US},
+                                 {PIN_B,HIGH,GLITCH_US}, {PIN_B,LOW,GLITCH_US}, {PIN_A,HIGH,STEP_US}, {PIN_B,HIGH,STEP_US} };
+  uint8_t i;
+
+  for (i=0;i<10;i++)
+    play(turn,sizeof(turn)/sizeof(turn[0]));
+  NativeArduino::advance(STEP_US);
+  TEST_ASSERT_EQUAL_INT(20,Enc.read());
+
+  Serial.clear();
+  Enc.report();
+  TEST_ASSERT_TRUE(Serial.output.find(" glitches=40 ") != std::string::npos);
+  TEST_ASSERT_TRUE(Serial.output.find(" invalid=0 ") != std::string::npos);
+}
+
+int main(int argc,char **argv){
+  UNITY_BEGIN();
+  RUN_TEST(test_edge_sequences);
+  RUN_TEST(test_detent_waits_for_settled_rest);
+  RUN_TEST(test_stays_in_sync_after_glitches);
+  return UNITY_END();
+}
@@ -0,0 +1,137 @@
+//
+// ButtonLadder events through the InputRouter ([env:native]).
+//
+// The ADC returns whatever level the test sets, the ladder is sampled every LADDER_SAMPLE_MS like pt3 does.  What a
+// button queues comes from its INPUT_LADDER binding, not from the table, so rebinding one changes it.
+//
+#include <Arduino.h>
+#include <unity.h>
+#include "ButtonLadder.h"
+#include "RadioProfile.h"
+
+#define LADDER_SAMPLE_MS  10
+#define LADDER_IDLE       1023
+
+static const LadderButton Table[] = {
+  {   0,  50, VOLUMEUP,   0,       LADDER_REPEAT },
+  {  95, 170, MUTE,       0,       LADDER_ONCE   },
+  { 200, 290, TRACKPV,    TRACKFF, LADDER_ONCE   },
+};
+
+static InputRouter  Router;
+static ButtonLadder Ladder;
+static uint16_t     Level;
+static uint8_t      Routed[64];
+static uint8_t      RoutedCount;
+
+static void sink(uint8_t cmd){
+  if (RoutedCount < sizeof(Routed))
+    Routed[RoutedCount]=cmd;
+  RoutedCount++;
+}
+
+static int onAnalogRead(uint8_t){ return Level; }
+
+static void runFor(uint32_t ms){
+  InputEvent event;
+
+  for (;ms >= LADDER_SAMPLE_MS;ms-=LADDER_SAMPLE_MS){
+    NativeArduino::advance(LADDER_SAMPLE_MS*1000UL);
+    if (Ladder.sample(event)){
+      TEST_ASSERT_EQUAL_UINT8(INPUT_LADDER,event.source);
+      Router.route(event);
+    }
+  }
+}
+
+static void press(uint8_t button,uint32_t ms){
+  Level=(Table[button].low+Table[button].high)/2;
+  runFor(ms);
+  Level=LADDER_IDLE;
+  runFor(100);
+}
+
+void setUp(){
+  uint8_t i;
+
+  NativeArduino::reset();
+  NativeArduino::onAnalogRead=onAnalogRead;
+  Level=LADDER_IDLE;
+  Router=InputRouter();
+  Router.begin(sink);
+  for (i=0;i<sizeof(Table)/sizeof(Table[0]);i++){      // what BindInputs() does
+    Router.bind(INPUT_LADDER,INPUT_PRESS,Table[i].command,i);
+    Router.bind(INPUT_LADDER,INPUT_LONG_PRESS,Table[i].holdCommand,i);
+  }
+  RoutedCount=0;
+  Ladder=ButtonLadder();
+  Ladder.begin(A0,Table,sizeof(Table)/sizeof(Table[0]));
+}
+
+void tearDown(){}
+
+void test_each_button_routes_its_binding(){
+  press(0,100);
+  press(1,100);
+  press(2,100);
+
+  TEST_ASSERT_EQUAL_UINT8(3,RoutedCount);
+  TEST_ASSERT_EQUAL_UINT8(VOLUMEUP,Routed[0]);
+  TEST_ASSERT_EQUAL_UINT8(MUTE,Routed[1]);
+  TEST_ASSERT_EQUAL_UINT8(TRACKPV,Routed[2]);
+}
+
+// LADDER_REPEAT auto-repeats, LADDER_ONCE doesn't
+void test_repeat_and_once(){
+  press(0,LADDER_HOLD_MS+3*LADDER_REPEAT_MS+LADDER_SAMPLE_MS);
+  TEST_ASSERT_EQUAL_UINT8(1+4,RoutedCount);
+
+  RoutedCount=0;
+  press(1,LADDER_HOLD_MS+3*LADDER_REPEAT_MS+LADDER_SAMPLE_MS);
+  TEST_ASSERT_EQUAL_UINT8(1,RoutedCount);
+}
+
+// a button with a hold action is a long press once held, nothing at release
+void test_hold_routes_long_press(){
+  press(2,LADDER_HOLD_MS+500);
+
+  TEST_ASSERT_EQUAL_UINT8(1,RoutedCount);
+  TEST_ASSERT_EQUAL_UINT8(TRACKFF,Routed[0]);
+}
+
+// the router owns the layout: rebinding a button or leaving it unbound changes what it queues
+void test_bindings_come_from_the_router(){
+  Router.bind(INPUT_LADDER,INPUT_PRESS,VOLUMEDOWN,1);
+  Router.bind(INPUT_LADDER,INPUT_PRESS,0,0);
+  press(1,100);
+  press(0,100);
+
+  TEST_ASSERT_EQUAL_UINT8(1,RoutedCount);
+  TEST_ASSERT_EQUAL_UINT8(VOLUMEDOWN,Routed[0]);
+  TEST_ASSERT_EQUAL_UINT32(1,Router.unbound());
+}
+
+// the ladder rows don't spill into the other sources
+void test_ladder_rows_are_separate(){
+  InputEvent event={ INPUT_BUTTON0, INPUT_PRESS, 1, 1, 0 };
+
+  Router.bind(INPUT_BUTTON0,INPUT_PRESS,MUTE);
+  TEST_ASSERT_EQUAL_UINT8(0,Router.route(event));              // index is only meaningful for INPUT_LADDER
+  event.index=0;
+  TEST_ASSERT_EQUAL_UINT8(MUTE,Router.route(event));
+  event.source=INPUT_LADDER;
+  event.index=INPUT_LADDER_BUTTONS;
+  TEST_ASSERT_EQUAL_UINT8(0,Router.route(event));
+  event.index=2;
+  TEST_ASSERT_EQUAL_UINT8(TRACKPV,Router.route(event));
+}
+
+int main(int argc,char **argv){
+  UNITY_BEGIN();
+  RUN_TEST(test_each_button_routes_its_binding);
+  RUN_TEST(test_repeat_and_once);
+  RUN_TEST(test_hold_routes_long_press);
+  RUN_TEST(test_bindings_come_from_the_router);
+  RUN_TEST(test_ladder_rows_are_separate);
+  return UNITY_END();
+}
@@ -0,0 +1,103 @@
+//
+// X9CPair never steps the pot the head unit is looking at ([env:native], X9C_TRACE).
+//
+// Home, then stage / present / release the way pt2 does under X9C_PINGPONG, against two X9CModel chips behind the
+// SEL line.  Two independent checks: the model's presented wiper only ever changes on a SEL flip (liveSteps), and
+// the X9C_TRACE capture of the same writes reports live_inc=0.  The last test steps the presented chip on purpose so
+// both checks are shown to fire.
+//
+#include <Arduino.h>
+#include <unity.h>
+#include "X9C.h"
+#include "X9CTrace.h"
+#include "RadioProfile.h"
+#include "../X9CModel.h"
+
+#define CS_A    D4
+#define CS_B    D7
+#define INC     D6
+#define UD      D5
+#define SEL     D0
+
+static X9CPair      Pair;
+static X9CPairModel Chips;
+static uint32_t     LiveIncReports;
+
+static const uint8_t Rests[]={ REST_VOLUMEUP, REST_VOLUMEUP, REST_VOLUMEDOWN, (uint8_t)REST_MUTE, REST_TRACKFF, REST_TRACKPV,
+                               REST_VOLUMEDOWN, REST_TRACKFF };
+
+static void onWrite(uint8_t pin,uint8_t level){ Chips.write(pin,level); }
+
+// the capture holds about one command, check it and count any live INC it found
+static void checkTrace(){
+  Serial.clear();
+  x9cTrace.report();
+  TEST_ASSERT_TRUE_MESSAGE(Serial.output.find("X9C live_inc=") != std::string::npos,"trace saw no SEL, not checking the pair");
+  if (Serial.output.find("X9C live_inc=0\n") == std::string::npos)
+    LiveIncReports++;
+}
+
+void setUp(){
+  NativeArduino::reset();
+  x9cTrace=X9CTrace();
+  Chips.chip[0].begin(CS_A,INC,UD,37);                  // wherever NVRAM left them
+  Chips.chip[1].begin(CS_B,INC,UD,62);
+  Chips.sel=SEL;
+  Chips.liveSteps=0;
+  LiveIncReports=0;
+  NativeArduino::onWrite=onWrite;
+  Pair=X9CPair();
+  Pair.begin(CS_A,CS_B,INC,UD,SEL);
+}
+
+void tearDown(){}
+
+void test_home_stage_present_release(){
+  uint8_t i;
+
+  Pair.setPotMax(true);                                 // HomePot
+  checkTrace();
+  TEST_ASSERT_EQUAL_INT(X9C_MAX,Chips.chip[0].wiper);
+  TEST_ASSERT_EQUAL_INT(X9C_MAX,Chips.chip[1].wiper);
+
+  Pair.stage(Rests[0]);
+  for (i=0;i<sizeof(Rests);i++){
+    x9cTrace.mark(i);
+    Pair.stage(Rests[i]);                               // press: normally staged already by the last release
+    Pair.present();
+    TEST_ASSERT_EQUAL_INT(Rests[i]+1,Chips.presented()); // setPot(pos,false) lands a step past, like the single pot
+    NativeArduino::advance((WaitForUnitToComplete+1)*1000UL);
+    Pair.present();                                     // release: back to the pot parked at max
+    TEST_ASSERT_EQUAL_INT(X9C_MAX,Chips.presented());
+    if (i+1 < sizeof(Rests))
+      Pair.stage(Rests[i+1]);                           // the next command goes onto the hidden pot
+    NativeArduino::advance((WaitForUnitToComplete+1)*1000UL);
+    checkTrace();
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(0,Chips.liveSteps);
+  TEST_ASSERT_EQUAL_UINT32(0,LiveIncReports);
+  TEST_ASSERT_EQUAL_UINT32(0,Pair.refused());
+  TEST_ASSERT_EQUAL_UINT32(2*sizeof(Rests),Pair.flips());
+}
+
+// a plain X9C on pot A's CS while A is presented, both checks have to see it
+void test_checks_catch_a_live_step(){
+  X9C direct;
+
+  Pair.setPotMax(true);
+  checkTrace();
+  direct.begin(CS_A,INC,UD);                            // same pins, the trace already knows them
+  direct.trimPot(5,X9C_DOWN,false);
+  checkTrace();
+
+  TEST_ASSERT_TRUE(Chips.liveSteps > 0);
+  TEST_ASSERT_EQUAL_UINT32(1,LiveIncReports);
+}
+
+int main(int argc,char **argv){
+  UNITY_BEGIN();
+  RUN_TEST(test_home_stage_present_release);
+  RUN_TEST(test_checks_catch_a_live_step);
+  return UNITY_END();
+}
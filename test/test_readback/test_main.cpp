@@ -0,0 +1,113 @@
+//
+// X9C readback against the documented wiring ([env:native]): Vh at the head unit's ground, Vw on its input with its
+// pull-up (X9C_READBACK_PULLUP_KOHM to READBACK_RAIL_V), Vl open, A0 reading the wiper through a unity gain buffer.
+//
+// The ADC model is that divider on an X9CModel wiper, 3.2V full scale, +-1 count of noise.  moveTo() has to land
+// where setPot() would and pass its verify on every position the dispatcher uses, and a lost INC pulse has to be
+// caught and re-homed.
+//
+#include <Arduino.h>
+#include <unity.h>
+#include "X9C.h"
+#include "RadioProfile.h"
+#include "TimingModel.h"
+#include "../X9CModel.h"
+
+#define CS              D4
+#define INC             D6
+#define UD              D5
+#define READBACK_RAIL_V 3.3                                 // the head unit's pull-up supply
+#define READBACK_MIN_R  0.3                                 // kOhm, wiper resistance at 0
+#define READBACK_RESOLVED 40                                // single steps told apart up to here
+
+static X9C      Pot;
+static X9CModel Chip;
+static uint32_t IncFalls, DropEvery, Noise;
+
+static void onWrite(uint8_t pin,uint8_t level){
+  if (pin == INC && level == LOW && NativeArduino::output(INC) == HIGH && NativeArduino::output(CS) == LOW)
+    if (DropEvery && ++IncFalls % DropEvery == 0)
+      return;                                               // a pulse the chip didn't see
+  Chip.write(pin,level);
+}
+
+static int onAnalogRead(uint8_t){
+  double r=READBACK_MIN_R+(double)Chip.wiper*X9C_KOHM/X9C_MAX;
+  double v=READBACK_RAIL_V*r/(X9C_READBACK_PULLUP_KOHM+r);
+  int    counts=(int)(v/3.2*1023+0.5)+(int)(Noise++ % 3)-1;
+
+  return counts > 1023 ? 1023:(counts < 0 ? 0:counts);
+}
+
+void setUp(){
+  NativeArduino::reset();
+  Chip.begin(CS,INC,UD,50);
+  IncFalls=DropEvery=Noise=0;
+  NativeArduino::onWrite=onWrite;
+  NativeArduino::onAnalogRead=onAnalogRead;
+  Pot=X9C();
+  Pot.begin(CS,INC,UD);
+  Pot.setReadback(A0);
+}
+
+void tearDown(){}
+
+void test_calibration_leaves_wiper_at_max(){
+  TEST_ASSERT_EQUAL_INT(X9C_MAX,Chip.wiper);
+  TEST_ASSERT_EQUAL_UINT8(X9C_MAX,Pot.position());
+}
+
+// press and release for every rest, the wiper ends up where open loop setPot(rest,false) would put it
+void test_move_to_verifies_every_rest(){
+  static const uint8_t rests[]={ REST_VOLUMEUP, REST_VOLUMEDOWN, (uint8_t)REST_MUTE, REST_TRACKFF, REST_TRACKPV };
+  uint8_t i;
+
+  for (i=0;i<sizeof(rests);i++){
+    TEST_ASSERT_TRUE(Pot.moveTo(rests[i],false));
+    TEST_ASSERT_EQUAL_INT(rests[i]+1,Chip.wiper);
+    TEST_ASSERT_EQUAL_UINT8(Chip.wiper,Pot.position());
+    TEST_ASSERT_TRUE(Pot.moveTo(X9C_MAX,false));
+    TEST_ASSERT_EQUAL_INT(X9C_MAX,Chip.wiper);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0,Pot.mismatches());
+  TEST_ASSERT_EQUAL_UINT32(2*sizeof(rests),Pot.verifies());
+}
+
+// every position a command rests at verifies against its own level and not against a neighbour's.  The pull-up
+// curve flattens towards max, above READBACK_RESOLVED a step is no bigger than the verify window plus the noise
+void test_each_position_is_told_apart(){
+  uint8_t pos;
+
+  TEST_ASSERT_TRUE(TimingModel::largestRest()+1 <= READBACK_RESOLVED);
+
+  for (pos=0;pos<=READBACK_RESOLVED;pos++){
+    Pot.setPot(pos,true);
+    TEST_ASSERT_TRUE_MESSAGE(Pot.verify(pos),"own level");
+    if (pos > 0)
+      TEST_ASSERT_FALSE_MESSAGE(Pot.verify(pos-1),"one below");
+    if (pos < X9C_MAX)
+      TEST_ASSERT_FALSE_MESSAGE(Pot.verify(pos+1),"one above");
+  }
+}
+
+// a lost pulse leaves the wiper a step short, verify sees it and moveTo re-homes to the right place
+void test_lost_pulse_is_rehomed(){
+  DropEvery=7;
+  Pot.moveTo(REST_VOLUMEDOWN,false);
+  DropEvery=0;
+  Pot.moveTo(X9C_MAX,false);
+  Pot.moveTo(REST_VOLUMEUP,false);
+
+  TEST_ASSERT_TRUE(Pot.mismatches() > 0);
+  TEST_ASSERT_EQUAL_INT(REST_VOLUMEUP+1,Chip.wiper);
+  TEST_ASSERT_EQUAL_UINT8(Chip.wiper,Pot.position());
+}
+
+int main(int argc,char **argv){
+  UNITY_BEGIN();
+  RUN_TEST(test_calibration_leaves_wiper_at_max);
+  RUN_TEST(test_move_to_verifies_every_rest);
+  RUN_TEST(test_each_position_is_told_apart);
+  RUN_TEST(test_lost_pulse_is_rehomed);
+  return UNITY_END();
+}
@@ -0,0 +1,86 @@
+//
+// Stalled loop() against the queue's 8 bit age stamps ([env:native]).
+//
+// pt2 works a batch, then loop() stalls (a VCD dump) the way it would on the target.  A stall just past 256 ticks
+// wraps the stamps, the queued commands read as fresh and would be played; the stall guard (DispatchTaskExpire(),
+// what loop() calls after a pass longer than stallExpireUs()) has to count them all as expired and let the batch
+// end cleanly after the command in flight.
+//
+#include <Arduino.h>
+#include <unity.h>
+#include "RadioTasks.h"
+#include "TimingModel.h"
+
+#define STALL_BATCH     6
+#define STALL_WRAP_MS   (256UL*COMMAND_AGE_TICK_MS+100)         // the stamps read 100ms old again
+#define STALL_DRAIN_MS  20000UL
+
+static X9C          Pot;
+static DispatchTask Dispatch;
+
+static uint32_t occurrences(const char *tag){
+  uint32_t n=0;
+  size_t   at=0;
+
+  while ((at=Serial.output.find(tag,at)) != std::string::npos){
+    n++;
+    at+=strlen(tag);
+  }
+  return n;
+}
+
+static void runDispatch(uint32_t ms){
+  while (ms--){
+    protothread2(&Dispatch);
+    NativeArduino::advance(1000);
+  }
+}
+
+void setUp(){
+  uint8_t i;
+
+  NativeArduino::reset();
+  Queue.clear();
+  Pot.begin(D4,D6,D5);
+  DispatchTaskInit(&Dispatch,&Queue,&Pot);
+  for (i=0;i<STALL_BATCH;i++)
+    PulseVolumeUp();
+  runDispatch(5);                                               // first command popped and pressed, batch running
+  TEST_ASSERT_TRUE(Dispatch.Busy);
+  Serial.clear();
+}
+
+void tearDown(){}
+
+// what the guard is for: without it the wrapped stamps pass the TTL check
+void test_wrapped_stamps_play_without_guard(){
+  NativeArduino::advance(STALL_WRAP_MS*1000);
+  runDispatch(STALL_DRAIN_MS);
+
+  TEST_ASSERT_EQUAL_UINT32(STALL_BATCH-1,occurrences("UP "));
+  TEST_ASSERT_EQUAL_UINT32(0,Dispatch.Expired[VOLUMEUP]);
+}
+
+void test_guard_expires_the_queue(){
+  NativeArduino::advance(STALL_WRAP_MS*1000);
+  TEST_ASSERT_TRUE(STALL_WRAP_MS > TimingModel::stallExpireUs()/1000);
+  TEST_ASSERT_EQUAL_UINT16(STALL_BATCH-1,DispatchTaskExpire(&Dispatch));
+  runDispatch(STALL_DRAIN_MS);
+
+  TEST_ASSERT_EQUAL_UINT32(0,occurrences("UP "));
+  TEST_ASSERT_EQUAL_UINT32(STALL_BATCH-1,Dispatch.Expired[VOLUMEUP]);
+  TEST_ASSERT_EQUAL_UINT32(0,occurrences("I hit 0"));
+  TEST_ASSERT_FALSE(Dispatch.Busy);
+  TEST_ASSERT_EQUAL_UINT8(X9C_MAX,Pot.position());              // the command in flight was still released
+
+  PulseVolumeDown();                                            // and the next batch runs normally
+  runDispatch(STALL_DRAIN_MS);
+  TEST_ASSERT_EQUAL_UINT32(1,occurrences("DOWN "));
+}
+
+int main(int argc,char **argv){
+  UNITY_BEGIN();
+  RUN_TEST(test_wrapped_stamps_play_without_guard);
+  RUN_TEST(test_guard_expires_the_queue);
+  return UNITY_END();
+}